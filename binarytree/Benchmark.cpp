@@ -0,0 +1,456 @@
+/**
+ * @brief Lookup benchmark for the binary tree's balancing modes.
+ *
+ * Builds the same tree once per mode and times retrieves drawn from a Zipfian
+ * distribution, where a few keys take most of the lookups, and from a uniform
+ * one for comparison. Hot keys are scattered across the key space, so no mode
+ * gets them near the root by accident. The array backed tree is timed next,
+ * in allocation order and after a van Emde Boas relayout, and the radix tree
+ * last. Keys are distinct IDs spread over all 32 bits. The list and its
+ * radix tree are compared in the list's own benchmark.
+ *
+ * A smaller key set fixed when the benchmark is compiled is then looked up
+ * in the static set built from it at compile time, which has nothing to
+ * load, and in a tree loaded and rebalanced at run time.
+ *
+ * Updates to values kept with the keys are timed next, in the map where
+ * they sit in the key's node and in a tree with a hash map alongside it,
+ * which has to delete and insert the key again.
+ *
+ * Concurrent ingestion follows: a growing number of threads insert the
+ * keys, split between them, into one tree behind one lock and into the
+ * sharded tree, whose shards each have their own.
+ *
+ * The threaded tree then reads every key a page at a time, resuming after
+ * the last key seen, once with a cursor per page and once with a next()
+ * from the root per key, and a cursor is walked across the tree while the
+ * keys around it are deleted, checking that it still steps through exactly
+ * the keys left.
+ *
+ * Finally readers take snapshots of the persistent tree while a writer
+ * keeps changing it, and check that every snapshot holds exactly the
+ * version it was taken at, however many writes come after. The benchmark
+ * exits with a failure if either check does not hold.
+ *
+ * Usage: ./benchmark [keys] [lookups] [skew]
+ *
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include "BinaryMap.h"
+#include "BinaryTree.h"
+#include "CompactBinaryTree.h"
+#include "PersistentBinaryTree.h"
+#include "RadixTree.h"
+#include "ShardedBinaryTree.h"
+#include "StaticSet.h"
+#include "ThreadedTree.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using std::vector;
+
+struct Mode {
+    const char * name;
+    bool balanced;    // rebalance with DSW once built
+    int splayPeriod;  // 0 for no splaying
+};
+
+static const Mode MODES[] = {
+    { "insertion order", false, 0 },
+    { "rebalanced",      true,  0 },
+    { "splay",           false, 1 },
+    { "splay every 4th", false, 4 },
+    { "splay every 16th", false, 16 },
+};
+
+/**
+ * The keys fixed at compile time, spread over all 32 bits like the others.
+ */
+template <int N>
+struct FixedKeys {
+    int keys[N];
+    constexpr FixedKeys() : keys() {
+        for (int i = 0; i < N; ++i) {
+            this->keys[i] = (int) ((uint32_t) i * 2654435761u);
+        }
+    };
+};
+
+static constexpr FixedKeys<4096> FIXED_KEYS;
+static constexpr auto FIXED = makeStaticSet(FIXED_KEYS.keys);
+
+/**
+ * Draws lookups keys, picking the key of rank r with probability
+ * proportional to 1 / r^skew. A skew of 0 is uniform.
+ */
+vector<int> zipfian(const vector<int> & keys, int lookups, double skew, std::mt19937 & random) {
+    vector<double> cumulative(keys.size());
+    double total = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        total += 1.0 / pow((double) (i + 1), skew);
+        cumulative[i] = total;
+    }
+    std::uniform_real_distribution<double> uniform(0, total);
+    vector<int> drawn(lookups);
+
+    for (int i = 0; i < lookups; ++i) {
+        size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(random))
+                    - cumulative.begin();
+        drawn[i] = keys[rank < keys.size() ? rank : keys.size() - 1];
+    }
+    return drawn;
+}
+
+/**
+ * Nanoseconds per retrieve over every drawn key.
+ */
+template <typename Tree>
+double timeLookups(Tree & tree, const vector<int> & drawn) {
+    int found = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < drawn.size(); ++i) {
+        ItemType item(drawn[i]);
+        bool present;
+        tree.retrieve(item, present);
+        found += present;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (found != (int) drawn.size()) {
+        fprintf(stderr, "lost %d keys\n", (int) drawn.size() - found);
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / drawn.size();
+}
+
+/**
+ * Nanoseconds per update of the drawn keys' values, in a BinaryMap or in a
+ * BinaryTree with the values in a hash map alongside it.
+ */
+double timeUpdates(const vector<int> & keys, const vector<int> & drawn, bool map) {
+    BinaryMap<long long> values;
+    BinaryTree tree;
+    std::unordered_map<int, long long> alongside;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ItemType item(keys[i]);
+        if (map) {
+            values.upsert(item, 0);
+        }
+        else {
+            tree.insertItem(item);
+            alongside[keys[i]] = 0;
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < drawn.size(); ++i) {
+        ItemType item(drawn[i]);
+        if (map) {
+            values.upsert(item, (long long) i);
+        }
+        else {
+            tree.deleteItem(item);
+            tree.insertItem(item);
+            alongside[drawn[i]] = (long long) i;
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if ((map ? values.length() : tree.length()) != (int) keys.size()) {
+        fprintf(stderr, "update changed the key count\n");
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / drawn.size();
+}
+
+/**
+ * Nanoseconds per insert with threads inserting their own share of keys
+ * at once. Every insert takes lock first, unless it is NULL because the
+ * tree does its own locking.
+ */
+template <typename Tree>
+double timeIngest(Tree & tree, const vector<int> & keys, int threads, std::mutex * lock) {
+    vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(std::thread([&, t]() {
+            for (size_t i = t; i < keys.size(); i += threads) {
+                ItemType item(keys[i]);
+                std::unique_lock<std::mutex> held;
+                if (lock != NULL) {
+                    held = std::unique_lock<std::mutex>(*lock);
+                }
+                tree.insertItem(item);
+            }
+        }));
+    }
+    for (int t = 0; t < threads; ++t) {
+        workers[t].join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (tree.length() != (int) keys.size()) {
+        fprintf(stderr, "lost %d keys\n", (int) keys.size() - tree.length());
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / keys.size();
+}
+
+/**
+ * Nanoseconds per key to read the whole tree in pages of pageSize keys,
+ * each page resuming after the last key of the one before. With cursors a
+ * page costs one descent and then a thread hop per key; without, every key
+ * is a next() from the root.
+ */
+static double timePages(ThreadedTree & tree, int pageSize, bool cursors) {
+    if (tree.length() == 0) {
+        return 0;
+    }
+    auto start = std::chrono::steady_clock::now();
+    ItemType last = tree.first().item();
+    int read = 1;
+    bool more = true;
+
+    while (more) {
+        if (cursors) {
+            ThreadedTree::Cursor cursor = tree.seekAfter(last);
+            for (int i = 0; i < pageSize && cursor.valid(); ++i, ++read, cursor.next()) {
+                last = cursor.item();
+            }
+            more = cursor.valid();
+        }
+        else {
+            ItemType following(last);
+            for (int i = 0; i < pageSize && (more = tree.next(last, following)); ++i, ++read) {
+                last = following;
+            }
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (read != tree.length()) {
+        fprintf(stderr, "paged through %d of %d keys\n", read, tree.length());
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / tree.length();
+}
+
+/**
+ * Walks a cursor from the first key to the last, deleting the key before it
+ * at every step and the key after it at every other step, and checks each
+ * step against a std::set with the same deletes. Returns the number of
+ * steps that landed on the wrong key.
+ */
+static int checkCursor(const vector<int> & keys, int * checked) {
+    ThreadedTree tree;
+    std::set<int> expected;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ItemType item(keys[i]);
+        tree.insertItem(item);
+        expected.insert(keys[i]);
+    }
+    int wrong = 0;
+    *checked = 0;
+    std::set<int>::iterator at = expected.begin();
+
+    for (ThreadedTree::Cursor cursor = tree.first(); cursor.valid(); cursor.next(), ++*checked) {
+        if (at == expected.end() || cursor.item().getValue() != *at) {
+            return wrong + 1;                                  // lost its place, stop here
+        }
+        if (at != expected.begin()) {
+            ItemType before(*std::prev(at));
+            tree.deleteItem(before);
+            expected.erase(std::prev(at));
+        }
+        if (*checked % 2 == 0 && std::next(at) != expected.end()) {
+            ItemType after(*std::next(at));
+            tree.deleteItem(after);
+            expected.erase(std::next(at));
+        }
+        ++at;
+    }
+    wrong += at != expected.end() || tree.length() != (int) expected.size();
+    return wrong;
+}
+
+/**
+ * Whether snapshot holds just what the writer in checkSnapshots had
+ * published at its version: keys 0 to n - 1 after the first n writes, and
+ * keys n - size to size - 1 after size + n.
+ */
+static bool holdsVersion(const PersistentBinaryTree::Snapshot & snapshot, int size) {
+    int low = snapshot.version() <= (uint64_t) size ? 0 : (int) snapshot.version() - size;
+    int high = snapshot.version() <= (uint64_t) size ? (int) snapshot.version() : size;
+    vector<ItemType> items;
+    snapshot.collect(items);
+
+    bool holds = (int) items.size() == high - low && snapshot.length() == high - low;
+    for (size_t i = 0; holds && i < items.size(); ++i) {
+        holds = items[i].getValue() == low + (int) i;
+    }
+    return holds;
+}
+
+/**
+ * Inserts keys 0 to size - 1 in order and then deletes them in order on one
+ * thread, while readers on the others take snapshots, keep some for a while
+ * and check them again once later writes have landed. Returns the number of
+ * snapshots that did not hold their version.
+ */
+static int checkSnapshots(int size, int readers, int * checked) {
+    PersistentBinaryTree tree;
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0), checks(0);
+    vector<std::thread> threads;
+
+    for (int r = 0; r < readers; ++r) {
+        threads.push_back(std::thread([&]() {
+            vector<PersistentBinaryTree::Snapshot> kept;
+            while (!done) {
+                kept.push_back(tree.snapshot());
+                if (kept.size() == 8) {                        // check again after more writes
+                    for (size_t i = 0; i < kept.size(); ++i) {
+                        failures += !holdsVersion(kept[i], size);
+                    }
+                    checks += kept.size();
+                    kept.clear();
+                }
+            }
+        }));
+    }
+    for (int i = 0; i < 2 * size; ++i) {
+        ItemType item(i % size);
+        if (i < size) {
+            tree.insertItem(item);
+        }
+        else {
+            tree.deleteItem(item);
+        }
+    }
+    done = true;
+    for (size_t r = 0; r < threads.size(); ++r) {
+        threads[r].join();
+    }
+    *checked = checks;
+    return failures;
+}
+
+int main(int argc, char * argv[]) {
+    int size = argc > 1 ? atoi(argv[1]) : 1 << 18;
+    int lookups = argc > 2 ? atoi(argv[2]) : 2000000;
+    double skew = argc > 3 ? atof(argv[3]) : 0.99;
+    std::mt19937 random(42);
+
+    vector<int> keys(size);
+    for (int i = 0; i < size; ++i) {
+        keys[i] = (int) ((uint32_t) i * 2654435761u);          // odd multiplier, so no repeats
+    }
+    vector<int> ranked(keys);
+    std::shuffle(keys.begin(), keys.end(), random);            // random insertion order,
+    std::shuffle(ranked.begin(), ranked.end(), random);        // and unrelated hot keys
+    vector<int> hot = zipfian(ranked, lookups, skew, random);
+    vector<int> cold = zipfian(ranked, lookups, 0, random);
+
+    printf("%d keys, %d lookups, skew %.2f\n\n", size, lookups, skew);
+    printf("%-18s %12s %12s %8s\n", "mode", "zipf ns/op", "unif ns/op", "height");
+
+    for (size_t m = 0; m < sizeof(MODES) / sizeof(MODES[0]); ++m) {
+        double timings[2];
+        int height = 0;
+
+        for (int pass = 0; pass < 2; ++pass) {                 // fresh tree per workload
+            BinaryTree tree;
+            for (int i = 0; i < size; ++i) {
+                ItemType item(keys[i]);
+                tree.insertItem(item);
+            }
+            if (MODES[m].balanced) {
+                tree.rebalance();
+            }
+            tree.setSplay(MODES[m].splayPeriod > 0, MODES[m].splayPeriod);
+            timings[pass] = timeLookups(tree, pass == 0 ? hot : cold);
+            if (pass == 0) {
+                height = tree.height();                        // shape the hot keys left
+            }
+        }
+        printf("%-18s %12.1f %12.1f %8d\n", MODES[m].name, timings[0], timings[1], height);
+    }
+
+    CompactBinaryTree compact;
+    for (int i = 0; i < size; ++i) {
+        ItemType item(keys[i]);
+        compact.insertItem(item);
+    }
+    for (int layout = 0; layout < 2; ++layout) {
+        if (layout == 1) {
+            compact.relayout();
+        }
+        printf("%-18s %12.1f %12.1f %8s\n", layout == 0 ? "compact" : "compact, vEB",
+               timeLookups(compact, hot), timeLookups(compact, cold), "-");
+    }
+
+    RadixTree radix;
+    for (int i = 0; i < size; ++i) {
+        ItemType item(keys[i]);
+        radix.insertItem(item);
+    }
+    printf("%-18s %12.1f %12.1f %8s\n", "radix", timeLookups(radix, hot), timeLookups(radix, cold), "-");
+
+    printf("\n%.1f bytes per key compact, %.1f radix, %d per node otherwise\n",
+           (double) compact.memoryUsed() / size, (double) radix.memoryUsed() / size, (int) sizeof(Node));
+
+    vector<int> fixed(FIXED_KEYS.keys, FIXED_KEYS.keys + FIXED.length());
+    std::shuffle(fixed.begin(), fixed.end(), random);
+    vector<int> fixedHot = zipfian(fixed, lookups, skew, random);
+    vector<int> fixedCold = zipfian(fixed, lookups, 0, random);
+    auto start = std::chrono::steady_clock::now();
+    BinaryTree loaded;
+    for (size_t i = 0; i < fixed.size(); ++i) {
+        ItemType item(fixed[i]);
+        loaded.insertItem(item);
+    }
+    loaded.rebalance();
+    double load = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("\n%-18s %12s %12s %12s\n", "4096 fixed keys", "zipf ns/op", "unif ns/op", "load ns/key");
+    printf("%-18s %12.1f %12.1f %12s\n", "static set",
+           timeLookups(FIXED, fixedHot), timeLookups(FIXED, fixedCold), "-");
+    printf("%-18s %12.1f %12.1f %12.1f\n", "loaded, rebalanced",
+           timeLookups(loaded, fixedHot), timeLookups(loaded, fixedCold), load / fixed.size());
+
+    printf("\n%-18s %12s %12s\n", "updates", "zipf ns/op", "unif ns/op");
+    printf("%-18s %12.1f %12.1f\n", "map upsert", timeUpdates(keys, hot, true), timeUpdates(keys, cold, true));
+    printf("%-18s %12.1f %12.1f\n", "delete, insert", timeUpdates(keys, hot, false), timeUpdates(keys, cold, false));
+
+    printf("\n%-18s %12s %12s\n", "threads", "locked ns/op", "shards ns/op");
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        BinaryTree locked;
+        ShardedBinaryTree sharded;
+        std::mutex lock;
+        double single = timeIngest(locked, keys, threads, &lock);
+        printf("%-18d %12.1f %12.1f\n", threads, single, timeIngest(sharded, keys, threads, NULL));
+    }
+
+    printf("\n");
+    ThreadedTree threaded;
+    for (int i = 0; i < size; ++i) {
+        ItemType item(keys[i]);
+        threaded.insertItem(item);
+    }
+    printf("paged scan, 100 keys per page: %.1f ns/key by cursor, %.1f by next()\n",
+           timePages(threaded, 100, true), timePages(threaded, 100, false));
+
+    int checked = 0;
+    int failures = checkCursor(vector<int>(keys.begin(), keys.begin() + std::min(size, 1 << 16)), &checked);
+    printf("%d cursor steps checked across deletes, %d wrong\n", checked, failures);
+
+    int readers = std::max(1, (int) std::thread::hardware_concurrency() - 1);
+    int wrong = checkSnapshots(std::min(size, 1 << 14), readers, &checked);
+    printf("%d snapshots checked under concurrent writes by %d readers, %d wrong\n", checked, readers, wrong);
+    return failures == 0 && wrong == 0 ? 0 : 1;
+}
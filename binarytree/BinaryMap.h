@@ -0,0 +1,193 @@
+/**
+ * @brief An ordered key to value map built on the binary tree's layout.
+ *
+ * BinaryTree only stores keys, so updating an entry kept alongside it means
+ * a deleteItem followed by an insertItem, two descents and a reallocation.
+ * BinaryMap stores the value in the node next to its key instead: upsert,
+ * find and emplace all descend once, and an update of an existing key
+ * overwrites its value in place without allocating.
+ *
+ * Being a template, the whole implementation lives in this header.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef BINARYMAP_H
+#define BINARYMAP_H
+
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include "ItemType.h"
+
+using std::ostream;
+
+template <typename Value>
+struct MapNode {
+    ItemType key;
+    Value value;
+    MapNode * left;
+    MapNode * right;
+
+    template <typename... Args>
+    explicit MapNode(ItemType & key, Args &&... args)
+        : key(key), value(std::forward<Args>(args)...), left(NULL), right(NULL) {};
+};
+
+template <typename Value>
+class BinaryMap {
+    public:
+        BinaryMap() : count(0), root(NULL) {};
+        ~BinaryMap() { clearNode(this->root); };
+        int length() const { return this->count; };
+
+        /**
+         * Sets the key's value, adding the key if it isn't in the map yet.
+         * Returns true if the key was added.
+         */
+        bool upsert(ItemType & key, const Value & value) {
+            MapNode<Value> ** slot = locate(key);
+            if (*slot != NULL) {
+                (*slot)->value = value;  // existing key, overwrite in place
+                return false;
+            }
+            *slot = new MapNode<Value>(key, value);
+            this->count++;
+            return true;
+        };
+
+        /**
+         * Constructs the key's value in place from args, unless the key is
+         * already in the map. Returns the key's value and whether it was added.
+         */
+        template <typename... Args>
+        std::pair<Value *, bool> emplace(ItemType & key, Args &&... args) {
+            MapNode<Value> ** slot = locate(key);
+            if (*slot != NULL) {
+                return std::pair<Value *, bool>(&(*slot)->value, false);
+            }
+            *slot = new MapNode<Value>(key, std::forward<Args>(args)...);
+            this->count++;
+            return std::pair<Value *, bool>(&(*slot)->value, true);
+        };
+
+        /**
+         * Returns a pointer to the key's value, or NULL if it isn't in the map.
+         */
+        Value * find(ItemType & key) {
+            MapNode<Value> * node = *locate(key);
+            return node != NULL ? &node->value : NULL;
+        };
+
+        const Value * find(ItemType & key) const {
+            const MapNode<Value> * node = locate(key);
+            return node != NULL ? &node->value : NULL;
+        };
+
+        /**
+         * Removes the key and its value. A node with two children is replaced
+         * by relinking its in order successor, so no value is ever copied.
+         */
+        void deleteItem(ItemType & key) {
+            MapNode<Value> ** slot = locate(key);
+            MapNode<Value> * node = *slot;
+            if (node == NULL) {
+                return;
+            }
+            if (node->left != NULL && node->right != NULL) {
+                MapNode<Value> ** successor = &node->right;
+                while ((*successor)->left != NULL) {
+                    successor = &(*successor)->left;
+                }
+                MapNode<Value> * next = *successor;
+                *successor = next->right;  // unlink the successor
+                next->left = node->left;   // and put it in the node's place
+                next->right = node->right;
+                *slot = next;
+            }
+            else {
+                *slot = node->left != NULL ? node->left : node->right;
+            }
+            this->count--;
+            delete node;
+        };
+
+        void clear() {
+            clearNode(this->root);
+            this->root = NULL;
+            this->count = 0;
+        };
+
+        friend ostream & operator<<(ostream & stream, const BinaryMap & map) {
+            map.ostreamRecurse(stream, map.root);
+            return stream;
+        };
+
+    private:
+        int count;
+        MapNode<Value> * root;
+
+        BinaryMap(const BinaryMap &);            // nodes are owned, no copies
+        BinaryMap & operator=(const BinaryMap &);
+
+        /**
+         * Finds the link that points at the key's node, or the empty link
+         * where it would be added, in a single descent.
+         */
+        MapNode<Value> ** locate(ItemType & key) {
+            MapNode<Value> ** node = &this->root;
+
+            while (*node != NULL) {
+                ItemType::Comparison comparison = key.compareTo((*node)->key);
+                if (comparison == ItemType::LESSER) {
+                    node = &(*node)->left;
+                }
+                else if (comparison == ItemType::GREATER) {
+                    node = &(*node)->right;
+                }
+                else {
+                    break;                 // key found
+                }
+            }
+            return node;
+        };
+
+        /**
+         * The key's node, or NULL if it isn't in the map.
+         */
+        const MapNode<Value> * locate(ItemType & key) const {
+            const MapNode<Value> * node = this->root;
+
+            while (node != NULL) {
+                ItemType::Comparison comparison = key.compareTo(node->key);
+                if (comparison == ItemType::LESSER) {
+                    node = node->left;
+                }
+                else if (comparison == ItemType::GREATER) {
+                    node = node->right;
+                }
+                else {
+                    break;                 // key found
+                }
+            }
+            return node;
+        };
+
+        void clearNode(MapNode<Value> * node) {
+            if (node != NULL) {
+                clearNode(node->left);
+                clearNode(node->right);
+                delete node;
+            }
+        };
+
+        void ostreamRecurse(ostream & stream, MapNode<Value> * node) const {
+            if (node != NULL) {
+                ostreamRecurse(stream, node->left);
+                stream << node->key << "=" << node->value << " ";
+                ostreamRecurse(stream, node->right);
+            }
+        };
+};
+
+#endif
@@ -11,20 +11,47 @@
  */
 
 #include <cstdlib>
+#include <climits>
+#include <cmath>
 #include <ostream>
 #include "BinaryTree.h"
+#include "Journal.h"
+#include "TaskPool.h"
 
 using std::ostream;
 using std::cout;
 using std::endl;
 
+static const int SEQUENTIAL_CUTOFF = 4096; // subtrees smaller than this aren't forked
+static const double MIN_REBALANCE_FACTOR = 1.5; // a rebuilt tree sits up to a level above log2(n)
+
+static long long countItem(const ItemType &) { return 1; };
+static long long valueItem(const ItemType & item) { return item.getValue(); };
+static long long add(long long a, long long b) { return a + b; };
+static long long lesser(long long a, long long b) { return a < b ? a : b; };
+static long long greater(long long a, long long b) { return a > b ? a : b; };
+
+const Aggregate BinaryTree::COUNT = { 0, countItem, add };
+const Aggregate BinaryTree::SUM = { 0, valueItem, add };
+const Aggregate BinaryTree::MINIMUM = { LLONG_MAX, valueItem, lesser };
+const Aggregate BinaryTree::MAXIMUM = { LLONG_MIN, valueItem, greater };
+
 BinaryTree::BinaryTree() {
     this->count = 0;    // initialize the list to have a size of 0
     this->root = NULL;  // initialize the root pointer to nothing
+    this->rebalanceFactor = 0; // automatic rebalancing is off by default
+    this->lazyDelete = false;  // deletes unlink nodes straight away by default
+    this->tombstoneThreshold = 0;
+    this->tombstones = 0;
+    this->splayPeriod = 0;     // no splaying by default
+    this->accesses = 0;
+    this->filter = NULL;       // no membership filter by default
+    this->journal = NULL;      // no journal until one is attached
 };
 
 BinaryTree::~BinaryTree() {
-   this->clear();       // call the clear function to destruct the class
+   clearNode(this->root); // release every node, without logging a clear
+   delete this->filter;
 };
 
 int BinaryTree::length() const {
@@ -32,60 +59,169 @@ int BinaryTree::length() const {
 };
 
 void BinaryTree::insertItem(ItemType & item) {
-    Node * node = new Node(item); // create a new node
-    insert(node, &(this->root));  // recursively insert the node
+    if (this->journal != NULL) {
+        this->journal->append(Journal::INSERT, item); // log ahead of the change
+    }
+    STATS_DESCENT_BEGIN;
+    int depth = insert(item, &(this->root), 1); // recursively insert the item
+    STATS_DESCENT_END;
+    if (depth > 0 && splayDue()) {
+        this->root = splay(item, this->root); // new items start out near the top
+    }
+    if (depth > 0 && this->filter != NULL) {
+        this->filter->add(item);
+        if (this->count > this->filter->getCapacity()) { // outgrown, resize to keep its rate
+            setFilter(2 * this->filter->getCapacity(), this->filter->getRate());
+        }
+    }
+                                  // rebuild if the new node sits too deep
+    if (this->rebalanceFactor > 0 &&
+        depth > this->rebalanceFactor * log2(this->count + this->tombstones + 1)) {
+        rebalance();
+    }
 };
 
-void BinaryTree::insert(Node * data, Node ** node) { // fun with double pointers
+/**
+ * Replaces the contents of the tree with items, which must already be in
+ * ascending order. The balanced tree is built directly in linear time rather
+ * than through one descent per item. Duplicates are dropped from items.
+ */
+void BinaryTree::build(std::vector<ItemType> & items) {
+    clear();
+    size_t distinct = 0;
+
+    for (size_t i = 0; i < items.size(); ++i) { // squeeze out duplicates in place
+        if (distinct == 0 || items[i].compareTo(items[distinct - 1]) != ItemType::EQUAL) {
+            items[distinct++] = items[i];
+        }
+    }
+    items.erase(items.begin() + distinct, items.end());
+
+    if (this->journal != NULL) {
+        for (size_t i = 0; i < items.size(); ++i) {
+            this->journal->append(Journal::INSERT, items[i]); // log ahead of the change
+        }
+    }
+    this->root = buildRecurse(items, 0, (int) items.size());
+    this->count = (int) items.size();
+
+    if (this->filter != NULL) {
+        setFilter(this->filter->getCapacity(), this->filter->getRate()); // refill from the new contents
+    }
+};
+
+/**
+ * Builds a balanced subtree out of items[low, high), the middle item
+ * becoming the subtree's root.
+ */
+Node * BinaryTree::buildRecurse(std::vector<ItemType> & items, int low, int high) {
+    if (low >= high) {
+        return NULL;
+    }
+    int middle = low + (high - low) / 2;
+    Node * node = new Node(items[middle]);
+    STATS_COUNT(allocations);
+    node->left = buildRecurse(items, low, middle);
+    node->right = buildRecurse(items, middle + 1, high);
+    return node;
+};
+
+/**
+ * Returns the depth the node was placed at, the root being at depth 1,
+ * or 0 if an equal item was already in the tree. The node is only created
+ * once an empty spot is found, so duplicates cost no allocation.
+ */
+int BinaryTree::insert(ItemType & item, Node ** node, int depth) { // fun with double pointers
     if (*node == NULL) {               // handle missing root node case
-        *node = data;                  // store the data in the node
+        *node = new Node(item);        // store the data in a new node
+        STATS_COUNT(allocations);
         this->count++;                 // increment the tree size counter 
+        return depth;
     }
-    else if (data->item.compareTo((*node)->item) == ItemType::LESSER) {
-        insert(data, &(*node)->left);  // recurse down the tree to the left
+    STATS_COUNT(visits);
+    ItemType::Comparison comparison = compare(item, *node);
+    if (comparison == ItemType::LESSER) {
+        return insert(item, &(*node)->left, depth + 1);  // recurse down the tree to the left
     } 
-    else if (data->item.compareTo((*node)->item) == ItemType::GREATER) {
-        insert(data, &(*node)->right); // recurse down the tree to the right
+    else if (comparison == ItemType::GREATER) {
+        return insert(item, &(*node)->right, depth + 1); // recurse down the tree to the right
     }
+    if ((*node)->deleted) {            // tombstone, bring it back to life
+        (*node)->deleted = false;
+        this->tombstones--;
+        this->count++;
+        return depth;
+    }
+    return 0;                          // duplicate, nothing inserted
 };
 
 void BinaryTree::deleteItem(ItemType & item) {
-    deleteRecurse(item, &this->root); // recursively delete the node
+    if (this->journal != NULL) {
+        this->journal->append(Journal::DELETE, item); // log ahead of the change
+    }
+    int before = this->count;
+    STATS_DESCENT_BEGIN;
+    if (this->lazyDelete) {           // only mark the node as deleted
+        Node * node = retrieveRecurse(item, this->root);
+        if (node != NULL && !node->deleted) {
+            node->deleted = true;
+            this->count--;
+            this->tombstones++;
+        }
+    }
+    else {
+        deleteRecurse(item, &this->root); // recursively delete the node
+    }
+    STATS_DESCENT_END;
+    if (this->count < before && this->filter != NULL) {
+        this->filter->remove(item);
+    }
+                                      // clean up once tombstones pile up
+    if (this->lazyDelete && this->tombstones > this->tombstoneThreshold * (this->count + this->tombstones)) {
+        compact();
+    }
 };
 
 void BinaryTree::deleteRecurse(ItemType & item, Node ** node) { // more fun with double pointers
     if (*node != NULL) {                            // handle root & leaf cases
-        if (item.compareTo((*node)->item) == ItemType::LESSER) {
+        STATS_COUNT(visits);
+        if (compare(item, *node) == ItemType::LESSER) {
             deleteRecurse(item, &((*node)->left));  // recurse down to left
         }
-        else if (item.compareTo((*node)->item) == ItemType::GREATER) {
+        else if (compare(item, *node) == ItemType::GREATER) {
             deleteRecurse(item, &((*node)->right)); // recurse down to right 
         }
         else {                                      // node found
-            Node * temp; // two children
-            if ((*node)->left != NULL && (*node)->right != NULL) {
-                Node * min = findMinimum(*node); // find minimum value node
-                (*node)->item = min->item;       // swap node values
-                temp = min;                      // set min node to be deleted
+            if ((*node)->left != NULL && (*node)->right != NULL) { // two children
+                Node * min = findMinimum((*node)->right);  // find in order successor
+                (*node)->item = min->item;                 // swap node values
+                deleteRecurse((*node)->item, &((*node)->right)); // unlink successor
             }     
             else {
-                temp = *node;
-                if ((*node)->left != NULL) {  // one child on left branch
-                    *node = (*node)->left;    // connect parent to grandchild
+                Node * temp = *node;
+                if (temp->left != NULL) {     // one child on left branch
+                    *node = temp->left;       // connect parent to grandchild
                 }
-                if ((*node)->right != NULL) { // one child on right branch
-                    *node = (*node)->right;   // connect parent to grandchild
-                }
-                else {
-                    *node = NULL;             // leaf node, just remove
+                else {                        // one child on right branch, or leaf
+                    *node = temp->right;      // connect parent to grandchild (or null)
                 }
+                this->count--; // decrement node count
+                delete temp;   // delete node
+                STATS_COUNT(deallocations);
             }
-            this->count--; // decrement node count
-            delete temp;   // delete node
         }
     }
 };
 
+/**
+ * Compares an item against a node's item. Every comparison made while
+ * descending the tree passes through here so that it can be counted.
+ */
+ItemType::Comparison BinaryTree::compare(ItemType & item, Node * node) const {
+    STATS_COUNT(comparisons);
+    return item.compareTo(node->item);
+};
+
 /**
  * Finds the minimum valued node on any given subtree.
  */
@@ -99,32 +235,63 @@ Node * BinaryTree::findMinimum(Node * node) {
 };
 
 void BinaryTree::retrieve(ItemType & item, bool & found) const {
-    found = retrieveRecurse(item, this->root); // recursively attempt to find node
+    if (this->filter != NULL && !this->filter->mayContain(item)) {
+        found = false;                               // certainly missing, skip the descent
+        return;
+    }
+    STATS_DESCENT_BEGIN;
+    Node * node;
+    if (splayDue()) {
+        this->root = splay(item, this->root);        // found or not, the last node
+        node = this->root != NULL && compare(item, this->root) == ItemType::EQUAL
+             ? this->root : NULL;                    // on the path is now the root
+    }
+    else {
+        node = retrieveRecurse(item, this->root);    // recursively attempt to find node
+    }
+    found = node != NULL && !node->deleted;          // tombstones don't count
+    STATS_DESCENT_END;
+    if (!found && this->filter != NULL) {
+        this->filter->recordFalsePositive();
+    }
 };
 
-bool BinaryTree::retrieveRecurse(ItemType & item, Node * node) const {
+/**
+ * Returns the node holding the item, tombstone or not, or NULL.
+ */
+Node * BinaryTree::retrieveRecurse(ItemType & item, Node * node) const {
     if (node != NULL) { // check if node exists
-        if (item.compareTo(node->item) == ItemType::LESSER) {
+        STATS_COUNT(visits);
+        if (compare(item, node) == ItemType::LESSER) {
             return retrieveRecurse(item, node->left);
         }               // node is greater than wanted value
-        if (item.compareTo(node->item) == ItemType::GREATER) {
+        if (compare(item, node) == ItemType::GREATER) {
             return retrieveRecurse(item, node->right);
         }               // node is lesser than wanted value
-        return true;    // node with value found
+        return node;    // node with value found
     }
-    return false;       // null node, value does not exist in tree
+    return NULL;        // null node, value does not exist in tree
 };
 
 void BinaryTree::clear() {
+    if (this->journal != NULL) {
+        ItemType none(0);
+        this->journal->append(Journal::CLEAR, none); // log ahead of the change
+    }
     clearNode(this->root); // recursively delete all nodes
     this->root = NULL;     // reset the root to null
     this->count = 0;       // specify that there are zero nodes in the tree
+    this->tombstones = 0;
+    if (this->filter != NULL) {
+        this->filter->reset();
+    }
 };
 
 void BinaryTree::clearNode(Node * node) {
     if (node != NULL) {    // iterate down all possible branches
         clearNode(node->left);
         clearNode(node->right);
+        STATS_COUNT(deallocations);
     }
     delete node;           // delete parent node
 };
@@ -136,7 +303,9 @@ void BinaryTree::preOrder() const {
 
 void BinaryTree::preOrderRecurse(Node * node) const {
     if (node != NULL) {                         // check if there is a node
-        cout << node->item.getValue() << + " "; // print value of the node
+        if (!node->deleted) {                   // skip tombstones
+            cout << node->item << + " ";        // print value of the node
+        }
         preOrderRecurse(node->left);            // recurse down left branch
         preOrderRecurse(node->right);           // recurse down right branch
     }
@@ -151,7 +320,9 @@ void BinaryTree::postOrderRecurse(Node * node) const {
     if (node != NULL) {                         // check if there is a node
         postOrderRecurse(node->left);           // recurse down left branch
         postOrderRecurse(node->right);          // recurse down right branch
-        cout << node->item.getValue() << + " "; // then print value of the node
+        if (!node->deleted) {                   // skip tombstones
+            cout << node->item << + " ";        // then print value of the node
+        }
     }
 };
 
@@ -163,11 +334,97 @@ void BinaryTree::inOrder() const {
 void BinaryTree::inOrderRecurse(Node * node) const {
     if (node != NULL) {                         // check if there is a node
         inOrderRecurse(node->left);             // recurse down left branch
-        cout << node->item.getValue() << + " "; // print value of the node
+        if (!node->deleted) {                   // skip tombstones
+            cout << node->item << + " ";        // print value of the node
+        }
         inOrderRecurse(node->right);            // finally recurse down the right
     }
 };
 
+/**
+ * Appends every item in the tree to items, in order.
+ */
+void BinaryTree::collect(std::vector<ItemType> & items) const {
+    collectRecurse(items, this->root);
+};
+
+void BinaryTree::collectRecurse(std::vector<ItemType> & items, Node * node) const {
+    if (node != NULL) {
+        collectRecurse(items, node->left);
+        if (!node->deleted) {
+            items.push_back(node->item);
+        }
+        collectRecurse(items, node->right);
+    }
+};
+
+/**
+ * Appends every item from low to high inclusive to items, in order. Only
+ * subtrees that can overlap the range are visited.
+ */
+void BinaryTree::range(ItemType & low, ItemType & high, std::vector<ItemType> & items) const {
+    rangeRecurse(low, high, items, this->root);
+};
+
+void BinaryTree::rangeRecurse(ItemType & low, ItemType & high, std::vector<ItemType> & items,
+                              Node * node) const {
+    if (node != NULL) {
+        STATS_COUNT(visits);
+        bool aboveLow = compare(low, node) != ItemType::GREATER;   // low <= item
+        bool belowHigh = compare(high, node) != ItemType::LESSER;  // item <= high
+        if (aboveLow) {
+            rangeRecurse(low, high, items, node->left);
+        }
+        if (aboveLow && belowHigh && !node->deleted) {
+            items.push_back(node->item);
+        }
+        if (belowHigh) {
+            rangeRecurse(low, high, items, node->right);
+        }
+    }
+};
+
+/**
+ * Reduces every item between low and high (inclusive) with the aggregate.
+ * Subtrees are forked onto the pool while they are likely large enough to
+ * be worth it, assuming a reasonably balanced tree, and reduced sequentially
+ * below that.
+ */
+long long BinaryTree::reduce(ItemType & low, ItemType & high, const Aggregate & aggregate,
+                             TaskPool & pool) const {
+    return reduceRecurse(low, high, aggregate, pool, this->root, 0);
+};
+
+long long BinaryTree::reduceRecurse(ItemType & low, ItemType & high, const Aggregate & aggregate,
+                                    TaskPool & pool, Node * node, int depth) const {
+    if (node == NULL) {
+        return aggregate.identity;
+    }
+    if (node->item.compareTo(low) == ItemType::LESSER) {   // range is right of node
+        return reduceRecurse(low, high, aggregate, pool, node->right, depth + 1);
+    }
+    if (node->item.compareTo(high) == ItemType::GREATER) { // range is left of node
+        return reduceRecurse(low, high, aggregate, pool, node->left, depth + 1);
+    }
+    long long left;
+    long long right;
+
+    if (depth < 31 && (this->count >> depth) >= SEQUENTIAL_CUTOFF && pool.size() > 1) { // no shift past the width
+        TaskPool::Group group(pool);                       // fork the left side
+        group.spawn([&] {
+            left = reduceRecurse(low, high, aggregate, pool, node->left, depth + 1);
+        });
+        right = reduceRecurse(low, high, aggregate, pool, node->right, depth + 1);
+        group.wait();                                      // and join it
+    }
+    else {
+        left = reduceRecurse(low, high, aggregate, pool, node->left, depth + 1);
+        right = reduceRecurse(low, high, aggregate, pool, node->right, depth + 1);
+    }
+    long long middle = node->deleted ? aggregate.identity : aggregate.map(node->item);
+    return aggregate.combine(aggregate.combine(left, middle), right);
+};
+
 ostream & operator<<(ostream & stream, const BinaryTree & tree) {
     tree.ostreamRecurse(stream, tree.root); // request ostream of tree in order
     return stream;
@@ -180,7 +437,371 @@ ostream & operator<<(ostream & stream, const BinaryTree & tree) {
 void BinaryTree::ostreamRecurse(ostream & stream, Node * node) const {
     if (node != NULL) {
         ostreamRecurse(stream, node->left);
-        stream << node->item.getValue() << + " ";
+        if (!node->deleted) {
+            stream << node->item << + " ";
+        }
         ostreamRecurse(stream, node->right);
     }
 };
+
+/**
+ * Rebuilds the tree into a perfectly balanced shape using the Day-Stout-Warren
+ * algorithm. Runs in linear time with constant extra memory: the existing
+ * nodes are only relinked by rotations, never reallocated.
+ */
+void BinaryTree::rebalance() {
+    ItemType placeholder(0);
+    Node pseudoRoot(placeholder);          // anchor so the real root can rotate
+    pseudoRoot.right = this->root;
+    int size = treeToVine(&pseudoRoot);    // flatten into a right leaning list
+    vineToTree(&pseudoRoot, size);         // then fold the list back into a tree
+    this->root = pseudoRoot.right;
+};
+
+/**
+ * Enables rebalancing whenever an insert lands deeper than
+ * factor * log2(count + 1). A factor of 0 (the default), or any factor
+ * below 0, disables it. Factors under MIN_REBALANCE_FACTOR are raised to
+ * it, as even a freshly rebuilt tree is deeper than log2(count + 1) and
+ * would be rebuilt again on nearly every insert.
+ */
+void BinaryTree::setAutoRebalance(double factor) {
+    if (factor <= 0) {
+        this->rebalanceFactor = 0;
+    }
+    else {
+        this->rebalanceFactor = factor < MIN_REBALANCE_FACTOR ? MIN_REBALANCE_FACTOR : factor;
+    }
+};
+
+/**
+ * Rotates every left child up until the tree is a sorted vine hanging off
+ * the right of the pseudo root. Returns the number of nodes in the vine.
+ */
+int BinaryTree::treeToVine(Node * pseudoRoot) {
+    Node * tail = pseudoRoot;
+    Node * rest = tail->right;
+    int size = 0;
+
+    while (rest != NULL) {
+        if (rest->left == NULL) {          // nothing to rotate, move down the vine
+            tail = rest;
+            rest = rest->right;
+            size++;
+        }
+        else {                             // rotate the left child up
+            Node * temp = rest->left;
+            rest->left = temp->right;
+            temp->right = rest;
+            rest = temp;
+            tail->right = temp;
+        }
+    }
+    return size;
+};
+
+/**
+ * Folds a vine of the given size into a balanced tree. The first pass only
+ * rotates enough nodes to leave a perfect tree plus a partial bottom level.
+ */
+void BinaryTree::vineToTree(Node * pseudoRoot, int size) {
+    int full = 1;
+    while (full <= size + 1) {             // largest 2^k - 1 not exceeding size
+        full *= 2;
+    }
+    full = full / 2 - 1;
+    compress(pseudoRoot, size - full);     // place the bottom level leaves
+    size = full;
+
+    while (size > 1) {                     // halve the vine until it is a tree
+        size /= 2;
+        compress(pseudoRoot, size);
+    }
+};
+
+/**
+ * Left rotates every other node along the right spine of the pseudo root.
+ */
+void BinaryTree::compress(Node * pseudoRoot, int rotations) {
+    Node * scanner = pseudoRoot;
+
+    for (int i = 0; i < rotations; ++i) {
+        Node * child = scanner->right;
+        scanner->right = child->right;
+        scanner = scanner->right;
+        child->right = scanner->left;
+        scanner->left = child;
+    }
+};
+
+/**
+ * Number of levels in the tree, 0 when empty. Tombstones still take up
+ * a place in the tree, so they count here and in the shape queries below.
+ */
+int BinaryTree::height() const {
+    return heightRecurse(this->root);
+};
+
+int BinaryTree::heightRecurse(Node * node) const {
+    if (node == NULL) {
+        return 0;
+    }
+    int left = heightRecurse(node->left);
+    int right = heightRecurse(node->right);
+    return 1 + (left > right ? left : right);
+};
+
+/**
+ * Average number of nodes a successful retrieve visits, the root counting
+ * as depth 1. Returns 0 for an empty tree.
+ */
+double BinaryTree::averageDepth() const {
+    if (this->count + this->tombstones == 0) {
+        return 0;
+    }
+    std::vector<int> histogram = depthHistogram();
+    long total = 0;
+
+    for (size_t i = 0; i < histogram.size(); ++i) {
+        total += (long) histogram[i] * (i + 1);
+    }
+    return (double) total / (this->count + this->tombstones);
+};
+
+/**
+ * Number of nodes on each level, index 0 being the root's level.
+ */
+std::vector<int> BinaryTree::depthHistogram() const {
+    std::vector<int> histogram;
+    histogramRecurse(histogram, this->root, 0);
+    return histogram;
+};
+
+void BinaryTree::histogramRecurse(std::vector<int> & histogram, Node * node, int depth) const {
+    if (node != NULL) {
+        if ((int) histogram.size() <= depth) {
+            histogram.push_back(0);        // first node seen on this level
+        }
+        histogram[depth]++;
+        histogramRecurse(histogram, node->left, depth + 1);
+        histogramRecurse(histogram, node->right, depth + 1);
+    }
+};
+
+/**
+ * In lazy mode a delete only marks its node as a tombstone, a single
+ * descent with no restructuring or freeing. Once tombstones make up more
+ * than threshold of all nodes they are removed in one compaction. Turning
+ * lazy mode off compacts straight away.
+ */
+void BinaryTree::setLazyDelete(bool enabled, double threshold) {
+    this->lazyDelete = enabled;
+    this->tombstoneThreshold = threshold;
+    if (!enabled && this->tombstones > 0) {
+        compact();
+    }
+};
+
+bool BinaryTree::isLazyDelete() const {
+    return this->lazyDelete;
+};
+
+/**
+ * Frees every tombstone and rebalances what is left, in one linear pass:
+ * the tree is flattened into a vine, tombstones are cut out of the vine,
+ * and the vine is folded back into a balanced tree.
+ */
+void BinaryTree::compact() {
+    ItemType placeholder(0);
+    Node pseudoRoot(placeholder);
+    pseudoRoot.right = this->root;
+    treeToVine(&pseudoRoot);
+
+    for (Node * previous = &pseudoRoot; previous->right != NULL; ) {
+        Node * node = previous->right;
+        if (node->deleted) {               // unlink and free the tombstone
+            previous->right = node->right;
+            delete node;
+            STATS_COUNT(deallocations);
+        }
+        else {
+            previous = node;
+        }
+    }
+    this->tombstones = 0;
+    vineToTree(&pseudoRoot, this->count);
+    this->root = pseudoRoot.right;
+};
+
+/**
+ * Number of deleted nodes still waiting for compaction.
+ */
+int BinaryTree::tombstoneCount() const {
+    return this->tombstones;
+};
+
+/**
+ * In splay mode every period-th retrieve or insert moves its node up to the
+ * root, so frequently used items gather near the top and a hot lookup ends
+ * within a level or two. With a period of 1 this is a plain splay tree,
+ * amortized O(log n) per access. A larger period rotates on fewer accesses,
+ * trading how quickly the tree adapts for fewer pointer writes; hot items
+ * are the ones most often sampled, so they still rise. Retrieve changes the
+ * tree in this mode, so concurrent retrieves need outside locking.
+ */
+void BinaryTree::setSplay(bool enabled, int period) {
+    this->splayPeriod = enabled ? (period > 1 ? period : 1) : 0;
+    this->accesses = 0;
+};
+
+bool BinaryTree::isSplaying() const {
+    return this->splayPeriod > 0;
+};
+
+/**
+ * Counts an access and returns true if this one should splay.
+ */
+bool BinaryTree::splayDue() const {
+    return this->splayPeriod > 0 && ++this->accesses % this->splayPeriod == 0;
+};
+
+/**
+ * Top down splay: a single descent towards the item, which rotates each
+ * zig-zig pair on the way and hangs the passed nodes off two side trees,
+ * then reassembles them around the last node reached. Returns the new root,
+ * which holds the item if it is in the subtree.
+ */
+Node * BinaryTree::splay(ItemType & item, Node * node) const {
+    if (node == NULL) {
+        return NULL;
+    }
+    ItemType placeholder(0);
+    Node header(placeholder);              // side trees hang off here
+    Node * lesser = &header;               // rightmost node of the lesser tree
+    Node * greater = &header;              // leftmost node of the greater tree
+
+    STATS_COUNT(visits);
+    ItemType::Comparison comparison = compare(item, node);
+
+    while (comparison != ItemType::EQUAL) {
+        if (comparison == ItemType::LESSER) {
+            if (node->left == NULL) {
+                break;
+            }
+            STATS_COUNT(visits);
+            comparison = compare(item, node->left);
+            if (comparison == ItemType::LESSER) { // zig-zig, rotate right
+                Node * temp = node->left;
+                node->left = temp->right;
+                temp->right = node;
+                node = temp;
+                if (node->left == NULL) {
+                    break;
+                }
+                STATS_COUNT(visits);
+                comparison = compare(item, node->left);
+            }
+            greater->left = node;          // node and its right go to the greater tree
+            greater = node;
+            node = node->left;
+        }
+        else {
+            if (node->right == NULL) {
+                break;
+            }
+            STATS_COUNT(visits);
+            comparison = compare(item, node->right);
+            if (comparison == ItemType::GREATER) { // zig-zig, rotate left
+                Node * temp = node->right;
+                node->right = temp->left;
+                temp->left = node;
+                node = temp;
+                if (node->right == NULL) {
+                    break;
+                }
+                STATS_COUNT(visits);
+                comparison = compare(item, node->right);
+            }
+            lesser->right = node;          // node and its left go to the lesser tree
+            lesser = node;
+            node = node->right;
+        }
+    }
+    lesser->right = node->left;            // reassemble around the node
+    greater->left = node->right;
+    node->left = header.right;
+    node->right = header.left;
+    return node;
+};
+
+/**
+ * Puts a counting Bloom filter sized for capacity items in front of
+ * retrieve, so most lookups of missing items return after a few hashed
+ * probes instead of a full descent. The filter is filled from the tree and
+ * kept in step with every later change, and is resized whenever the tree
+ * outgrows it. A capacity of 0 removes the filter.
+ */
+void BinaryTree::setFilter(int capacity, double falsePositiveRate) {
+    delete this->filter;
+    this->filter = NULL;
+
+    if (capacity > 0) {
+        this->filter = new BloomFilter(capacity > this->count ? capacity : this->count,
+                                       falsePositiveRate);
+        filterRecurse(this->root);
+    }
+};
+
+void BinaryTree::filterRecurse(Node * node) {
+    if (node != NULL) {
+        if (!node->deleted) {
+            this->filter->add(node->item);
+        }
+        filterRecurse(node->left);
+        filterRecurse(node->right);
+    }
+};
+
+/**
+ * How well the filter is doing, all zeros if there is no filter.
+ */
+FilterStats BinaryTree::filterStats() const {
+    return this->filter != NULL ? this->filter->stats(this->count) : FilterStats();
+};
+
+/**
+ * Logs every following insert and delete to the journal, pass NULL to stop.
+ */
+void BinaryTree::attachJournal(Journal * journal) {
+    this->journal = journal;
+};
+
+TreeStats BinaryTree::stats() const {
+#ifdef TREE_STATS
+    return this->statistics; // snapshot of the counters collected so far
+#else
+    return TreeStats();      // counters are compiled out, report zeros
+#endif
+};
+
+void BinaryTree::resetStats() {
+#ifdef TREE_STATS
+    this->statistics = TreeStats();
+#endif
+    if (this->filter != NULL) {
+        this->filter->resetStats();
+    }
+};
+
+#ifdef TREE_STATS
+/**
+ * Closes off a single descent, the number of nodes visited since it started
+ * is the depth that the descent reached.
+ */
+void BinaryTree::recordDescent(unsigned long start) const {
+    int depth = (int) (this->statistics.visits - start);
+    if (depth > this->statistics.maxDepth) {
+        this->statistics.maxDepth = depth;
+    }
+};
+#endif
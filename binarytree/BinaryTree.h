@@ -11,36 +11,104 @@
 #define BINARYTREE_H
 
 #include "Node.h"
+#include "TreeStats.h"
+#include "BloomFilter.h"
 #include <iostream>
+#include <vector>
 
 using std::ostream;
 
+class Journal;
+class TaskPool;
+
+/**
+ * An associative reduction: every item in range is mapped to a number, and
+ * the numbers are folded together with combine, starting from identity.
+ */
+struct Aggregate {
+    long long identity;
+    long long (*map)(const ItemType & item);
+    long long (*combine)(long long a, long long b);
+};
+
 class BinaryTree {
     public:
+        static const Aggregate COUNT;
+        static const Aggregate SUM;
+        static const Aggregate MINIMUM;
+        static const Aggregate MAXIMUM;
+
         BinaryTree();
         ~BinaryTree();
         int length() const;
         void insertItem(ItemType & item);
+        void build(std::vector<ItemType> & items);
         void deleteItem(ItemType & item);
         void retrieve(ItemType & item, bool & found) const;
         void clear();
         void preOrder() const;
         void postOrder() const;
         void inOrder() const;
+        void collect(std::vector<ItemType> & items) const;
+        void range(ItemType & low, ItemType & high, std::vector<ItemType> & items) const;
+        long long reduce(ItemType & low, ItemType & high, const Aggregate & aggregate, TaskPool & pool) const;
+        void rebalance();
+        void setAutoRebalance(double factor);
+        int height() const;
+        double averageDepth() const;
+        std::vector<int> depthHistogram() const;
+        void setLazyDelete(bool enabled, double threshold = 0.25);
+        bool isLazyDelete() const;
+        void compact();
+        int tombstoneCount() const;
+        void setSplay(bool enabled, int period = 1);
+        bool isSplaying() const;
+        void setFilter(int capacity, double falsePositiveRate = 0.01);
+        FilterStats filterStats() const;
+        void attachJournal(Journal * journal);
+        TreeStats stats() const;
+        void resetStats();
         friend ostream & operator<<(ostream & stream, const BinaryTree & list);
+        friend class Journal;
 
     private:
         int count;
-        Node * root;
-        void insert(Node * data, Node ** node);
+        mutable Node * root;     // splay mode reshapes the tree on retrieve
+        double rebalanceFactor;
+        bool lazyDelete;
+        double tombstoneThreshold;
+        int tombstones;
+        int splayPeriod;
+        mutable unsigned long accesses;
+        BloomFilter * filter;
+        Journal * journal;
+#ifdef TREE_STATS
+        mutable TreeStats statistics;
+        void recordDescent(unsigned long start) const;
+#endif
+        ItemType::Comparison compare(ItemType & item, Node * node) const;
+        int insert(ItemType & item, Node ** node, int depth);
+        Node * buildRecurse(std::vector<ItemType> & items, int low, int high);
         void deleteRecurse(ItemType & item, Node ** node);
         Node * findMinimum(Node * node);
         void clearNode(Node * node);
         void preOrderRecurse(Node * node) const;
         void postOrderRecurse(Node * node) const;
         void inOrderRecurse(Node * node) const;
-        bool retrieveRecurse(ItemType & item, Node * node) const;
+        Node * retrieveRecurse(ItemType & item, Node * node) const;
+        bool splayDue() const;
+        Node * splay(ItemType & item, Node * node) const;
         void ostreamRecurse(ostream & stream, Node * node) const;
+        void collectRecurse(std::vector<ItemType> & items, Node * node) const;
+        void rangeRecurse(ItemType & low, ItemType & high, std::vector<ItemType> & items, Node * node) const;
+        void filterRecurse(Node * node);
+        long long reduceRecurse(ItemType & low, ItemType & high, const Aggregate & aggregate,
+                                TaskPool & pool, Node * node, int depth) const;
+        int treeToVine(Node * pseudoRoot);
+        void vineToTree(Node * pseudoRoot, int size);
+        void compress(Node * pseudoRoot, int rotations);
+        int heightRecurse(Node * node) const;
+        void histogramRecurse(std::vector<int> & histogram, Node * node, int depth) const;
 };
 
 #endif
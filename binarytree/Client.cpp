@@ -0,0 +1,194 @@
+/**
+ * @brief Load generator for the tree's server mode.
+ *
+ * Opens one connection and sends requests in pipelined batches: a whole
+ * batch is written at once, then every reply is read back before the next
+ * batch goes out. Reports the request rate and the round trip time of a
+ * batch. Run several clients side by side to load the server from more
+ * than one connection.
+ *
+ * Usage: ./client (-u path | -t port) [requests] [depth] [keys] [reads]
+ *
+ *   requests  total requests to send, default 1000000
+ *   depth     requests per pipelined batch, default 64
+ *   keys      keys are drawn uniformly from [0, keys), default 100000
+ *   reads     percentage of lookups, default 90; one lookup in 50 is a
+ *             range of up to 100 keys, the other requests are split evenly
+ *             between inserts and deletes
+ *
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "ItemType.h"
+
+using std::string;
+using std::vector;
+
+/**
+ * Connects to a Unix domain socket (-u) or a loopback TCP port (-t).
+ */
+int connectTo(const string & option, const char * target) {
+    int fd = -1;
+    if (option == "-u") {
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, target, sizeof(address.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    else if (option == "-t") {
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons((uint16_t) atoi(target));
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    return fd;
+}
+
+void writeKey(string & data, int value) {
+    ItemType item(value);
+    uint32_t size = (uint32_t) item.getSize();
+    data.push_back((char) item.getKind());
+    data.append((const char *) &size, sizeof(uint32_t));
+    data.append(item.getBytes(), size);
+}
+
+/**
+ * Length of the reply to operation starting at offset, or 0 if it hasn't
+ * all arrived yet. Only a range reply is longer than a single byte.
+ */
+size_t replyLength(char operation, const string & data, size_t offset) {
+    if (operation != 'g') {
+        return data.size() > offset ? 1 : 0;
+    }
+    if (data.size() < offset + sizeof(uint32_t)) {
+        return 0;
+    }
+    uint32_t count;
+    size_t length = sizeof(uint32_t);
+    memcpy(&count, data.data() + offset, sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t size;
+        if (data.size() < offset + length + 1 + sizeof(uint32_t)) {
+            return 0;
+        }
+        memcpy(&size, data.data() + offset + length + 1, sizeof(uint32_t));
+        length += 1 + sizeof(uint32_t) + size;
+    }
+    return data.size() >= offset + length ? length : 0;
+}
+
+int main(int argc, char * argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s (-u path | -t port) [requests] [depth] [keys] [reads]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int requests = argc > 3 ? atoi(argv[3]) : 1000000;
+    int depth = argc > 4 ? std::max(atoi(argv[4]), 1) : 64;
+    int keys = argc > 5 ? std::max(atoi(argv[5]), 1) : 100000;
+    int reads = argc > 6 ? atoi(argv[6]) : 90;
+
+    int fd = connectTo(argv[1], argv[2]);
+    if (fd < 0) {
+        fprintf(stderr, "unable to connect to %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 random(getpid());
+    vector<double> latencies;
+    vector<char> operations;
+    string batch;
+    string replies;
+    char chunk[65536];
+    unsigned long found = 0, changed = 0, ranged = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int sent = 0; sent < requests; sent += depth) {
+        batch.clear();
+        operations.clear();
+
+        for (int i = 0; i < depth && sent + i < requests; ++i) {
+            int key = (int) (random() % keys);
+            int roll = (int) (random() % 100);
+            char operation = roll < reads ? (random() % 50 == 0 ? 'g' : 'r') : (roll % 2 ? 'i' : 'd');
+            batch.push_back(operation);
+            writeKey(batch, key);
+            if (operation == 'g') {
+                writeKey(batch, key + 99);
+            }
+            operations.push_back(operation);
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t written = 0; written < batch.size(); ) { // the whole batch in one go
+            ssize_t size = write(fd, batch.data() + written, batch.size() - written);
+            if (size <= 0) {
+                fprintf(stderr, "connection lost\n");
+                return EXIT_FAILURE;
+            }
+            written += size;
+        }
+
+        replies.clear();
+        size_t offset = 0;
+        for (size_t i = 0; i < operations.size(); ) {
+            size_t length = replyLength(operations[i], replies, offset);
+            if (length == 0) {             // wait for more of the replies
+                ssize_t size = read(fd, chunk, sizeof(chunk));
+                if (size <= 0) {
+                    fprintf(stderr, "connection lost\n");
+                    return EXIT_FAILURE;
+                }
+                replies.append(chunk, size);
+                continue;
+            }
+            if (operations[i] == 'g') {
+                uint32_t count;
+                memcpy(&count, replies.data() + offset, sizeof(uint32_t));
+                ranged += count;
+            }
+            else if (replies[offset]) {
+                (operations[i] == 'r' ? found : changed)++;
+            }
+            offset += length;
+            ++i;
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - begin).count());
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::sort(latencies.begin(), latencies.end());
+    close(fd);
+
+    printf("%d requests in %.2f s, %.0f requests/s\n", requests, elapsed, requests / elapsed);
+    if (!latencies.empty()) {
+        printf("batch of %d round trip: p50 %.1f us, p99 %.1f us, max %.1f us\n", depth,
+               latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies.back());
+    }
+    printf("%lu found, %lu inserted or deleted, %lu keys in ranges\n", found, changed, ranged);
+    return EXIT_SUCCESS;
+}
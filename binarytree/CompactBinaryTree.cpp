@@ -0,0 +1,369 @@
+/**
+ * @brief Function implementations for the array backed binary tree.
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include "CompactBinaryTree.h"
+
+using std::cout;
+using std::endl;
+using std::ostream;
+using std::vector;
+
+struct CompactHeader {     // start of a saved tree, followed by its nodes
+    uint32_t root;
+    uint32_t unused;
+    int32_t count;
+    uint32_t slots;
+};
+
+CompactBinaryTree::CompactBinaryTree() {
+    this->root = NONE;
+    this->unused = NONE;
+    this->count = 0;
+};
+
+int CompactBinaryTree::length() const {
+    return this->count;
+};
+
+void CompactBinaryTree::insertItem(ItemType & item) {
+    if (item.getKind() != ItemType::INTEGER) {
+        return;
+    }
+    int32_t key = item.getValue();
+    uint32_t parent = NONE;                // links are kept as indices, as the
+    bool lesser = false;                   // array may grow under any pointer
+    uint32_t slot = this->root;
+
+    while (slot != NONE) {
+        const CompactNode & node = this->nodes[slot];
+        if (key == node.key) {
+            return;                        // duplicate, nothing inserted
+        }
+        parent = slot;
+        lesser = key < node.key;
+        slot = lesser ? node.left : node.right;
+    }
+    slot = allocate(key);
+    if (parent == NONE) {
+        this->root = slot;
+    }
+    else if (lesser) {
+        this->nodes[parent].left = slot;
+    }
+    else {
+        this->nodes[parent].right = slot;
+    }
+    this->count++;
+};
+
+/**
+ * Replaces the contents of the tree with items, laid out balanced and in
+ * van Emde Boas order. Items may come in any order, and repeats are dropped.
+ */
+void CompactBinaryTree::build(vector<ItemType> & items) {
+    vector<int32_t> keys;
+    keys.reserve(items.size());
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (items[i].getKind() == ItemType::INTEGER) {
+            keys.push_back(items[i].getValue());
+        }
+    }
+    if (!std::is_sorted(keys.begin(), keys.end())) { // already sorted input skips the sort
+        std::sort(keys.begin(), keys.end());
+    }
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    layout(keys);
+};
+
+/**
+ * A node with two children is replaced by relinking its in order
+ * successor. The freed slot is kept for the next insert.
+ */
+void CompactBinaryTree::deleteItem(ItemType & item) {
+    if (item.getKind() != ItemType::INTEGER) {
+        return;
+    }
+    int32_t key = item.getValue();
+    uint32_t * link = &this->root;
+
+    while (*link != NONE && this->nodes[*link].key != key) {
+        CompactNode & node = this->nodes[*link];
+        link = key < node.key ? &node.left : &node.right;
+    }
+    if (*link == NONE) {
+        return;                            // not in the tree
+    }
+    uint32_t slot = *link;
+    CompactNode & node = this->nodes[slot];
+
+    if (node.left != NONE && node.right != NONE) {
+        uint32_t * successor = &node.right;
+        while (this->nodes[*successor].left != NONE) {
+            successor = &this->nodes[*successor].left;
+        }
+        uint32_t next = *successor;
+        *successor = this->nodes[next].right; // unlink the successor
+        this->nodes[next].left = node.left;   // and put it in the node's place
+        this->nodes[next].right = node.right;
+        *link = next;
+    }
+    else {
+        *link = node.left != NONE ? node.left : node.right;
+    }
+    node.left = this->unused;              // chain the slot for reuse
+    this->unused = slot;
+    this->count--;
+};
+
+void CompactBinaryTree::retrieve(ItemType & item, bool & found) const {
+    found = false;
+    if (item.getKind() != ItemType::INTEGER) {
+        return;
+    }
+    int32_t key = item.getValue();
+    uint32_t slot = this->root;
+
+    while (slot != NONE) {
+        const CompactNode & node = this->nodes[slot];
+        if (key == node.key) {
+            found = true;
+            return;
+        }
+        slot = key < node.key ? node.left : node.right;
+    }
+};
+
+void CompactBinaryTree::clear() {
+    this->nodes.clear();
+    this->root = NONE;
+    this->unused = NONE;
+    this->count = 0;
+};
+
+void CompactBinaryTree::inOrder() const {
+    cout << *this << endl;
+};
+
+/**
+ * Rebuilds the tree balanced, in van Emde Boas order, and without any
+ * unused slots.
+ */
+void CompactBinaryTree::relayout() {
+    vector<int32_t> keys;
+    collect(keys);
+    layout(keys);
+};
+
+/**
+ * Bytes held by the node array, unused slots and spare capacity included.
+ */
+size_t CompactBinaryTree::memoryUsed() const {
+    return this->nodes.capacity() * sizeof(CompactNode);
+};
+
+/**
+ * Writes the node array to path exactly as it sits in memory.
+ */
+bool CompactBinaryTree::save(const std::string & path) const {
+    FILE * file = fopen(path.c_str(), "wb");
+    if (file == NULL) {
+        return false;
+    }
+    CompactHeader header = { this->root, this->unused, this->count, (uint32_t) this->nodes.size() };
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(this->nodes.data(), sizeof(CompactNode), this->nodes.size(), file) == this->nodes.size();
+    return fclose(file) == 0 && written;
+};
+
+/**
+ * Replaces the tree with one written by save. The tree is left unchanged
+ * if the file can't be read or doesn't hold a valid tree.
+ */
+bool CompactBinaryTree::load(const std::string & path) {
+    FILE * file = fopen(path.c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+    CompactHeader header;
+    vector<CompactNode> nodes;
+    long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    bool valid = size >= (long) sizeof(header) && fseek(file, 0, SEEK_SET) == 0 &&
+                 fread(&header, sizeof(header), 1, file) == 1 &&  // the array must be exactly
+                 (size_t) size - sizeof(header) == (size_t) header.slots * sizeof(CompactNode); // the rest
+    if (valid) {
+        nodes.resize(header.slots);
+        valid = fread(nodes.data(), sizeof(CompactNode), nodes.size(), file) == nodes.size();
+    }
+    fclose(file);
+
+    if (!valid || !isValid(nodes, header.root, header.unused, header.count)) {
+        return false;
+    }
+    this->nodes.swap(nodes);
+    this->root = header.root;
+    this->unused = header.unused;
+    this->count = header.count;
+    return true;
+};
+
+/**
+ * Checks that nodes hold a tree a search can't go wrong in: every index is
+ * in the array, every slot is reached at most once, from root or along the
+ * unused chain, so there are no cycles, the keys are in search tree order,
+ * and count is the number of nodes in the tree.
+ */
+bool CompactBinaryTree::isValid(const vector<CompactNode> & nodes, uint32_t root, uint32_t unused, int count) {
+    vector<bool> seen(nodes.size(), false);
+    vector<uint32_t> stack;
+    uint32_t slot = root;
+    int reached = 0;
+    bool first = true;
+    int32_t previous = 0;
+
+    while (slot != NONE || !stack.empty()) { // in order, as collect does
+        while (slot != NONE) {
+            if (slot >= nodes.size() || seen[slot]) {
+                return false;
+            }
+            seen[slot] = true;
+            stack.push_back(slot);
+            slot = nodes[slot].left;
+        }
+        slot = stack.back();
+        stack.pop_back();
+        if (!first && nodes[slot].key <= previous) {
+            return false;                  // out of order, or a repeat
+        }
+        first = false;
+        previous = nodes[slot].key;
+        reached++;
+        slot = nodes[slot].right;
+    }
+    for (slot = unused; slot != NONE; slot = nodes[slot].left) {
+        if (slot >= nodes.size() || seen[slot]) {
+            return false;
+        }
+        seen[slot] = true;
+    }
+    return reached == count;
+};
+
+ostream & operator<<(ostream & stream, const CompactBinaryTree & tree) {
+    vector<int32_t> keys;
+    tree.collect(keys);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        stream << keys[i] << " ";
+    }
+    return stream;
+};
+
+/**
+ * Takes a slot for a new leaf, reusing a deleted one when there is one.
+ */
+uint32_t CompactBinaryTree::allocate(int32_t key) {
+    CompactNode node = { key, NONE, NONE };
+    if (this->unused != NONE) {
+        uint32_t slot = this->unused;
+        this->unused = this->nodes[slot].left;
+        this->nodes[slot] = node;
+        return slot;
+    }
+    this->nodes.push_back(node);
+    return (uint32_t) (this->nodes.size() - 1);
+};
+
+/**
+ * Appends every key in order. Uses an explicit stack, as a tree grown in
+ * allocation order may be far too deep to recurse through.
+ */
+void CompactBinaryTree::collect(vector<int32_t> & keys) const {
+    vector<uint32_t> stack;
+    uint32_t slot = this->root;
+
+    while (slot != NONE || !stack.empty()) {
+        while (slot != NONE) {
+            stack.push_back(slot);
+            slot = this->nodes[slot].left;
+        }
+        slot = stack.back();
+        stack.pop_back();
+        keys.push_back(this->nodes[slot].key);
+        slot = this->nodes[slot].right;
+    }
+};
+
+/**
+ * Replaces the array with a balanced tree over keys, which are in order.
+ * The node for keys[middle] of every range goes in the slot the van Emde
+ * Boas order gives it, then the children are linked up by those slots.
+ */
+void CompactBinaryTree::layout(const vector<int32_t> & keys) {
+    int levels = 0;
+    while (((size_t) 1 << levels) - 1 < keys.size()) {
+        levels++;
+    }
+    vector<uint32_t> position(keys.size());
+    this->nodes.clear();
+    this->nodes.reserve(keys.size());
+    layoutRecurse(keys, 0, (int) keys.size(), levels, position);
+
+    this->root = linkRecurse(keys, 0, (int) keys.size(), position);
+    this->unused = NONE;
+    this->count = (int) keys.size();
+};
+
+/**
+ * Places the top levels of the subtree over keys[low, high): the top half
+ * of those levels first, then each subtree hanging below it in turn.
+ */
+void CompactBinaryTree::layoutRecurse(const vector<int32_t> & keys, int low, int high, int levels,
+                                      vector<uint32_t> & position) {
+    if (low >= high || levels == 0) {
+        return;
+    }
+    if (levels == 1) {
+        int middle = low + (high - low) / 2;
+        CompactNode node = { keys[middle], NONE, NONE };
+        position[middle] = (uint32_t) this->nodes.size();
+        this->nodes.push_back(node);
+        return;
+    }
+    int top = levels / 2;
+    layoutRecurse(keys, low, high, top, position);
+    layoutBottoms(keys, low, high, top, levels - top, position);
+};
+
+/**
+ * Places each subtree that starts depth levels below keys[low, high).
+ */
+void CompactBinaryTree::layoutBottoms(const vector<int32_t> & keys, int low, int high, int depth,
+                                      int levels, vector<uint32_t> & position) {
+    if (low >= high) {
+        return;
+    }
+    if (depth == 0) {
+        layoutRecurse(keys, low, high, levels, position);
+        return;
+    }
+    int middle = low + (high - low) / 2;
+    layoutBottoms(keys, low, middle, depth - 1, levels, position);
+    layoutBottoms(keys, middle + 1, high, depth - 1, levels, position);
+};
+
+uint32_t CompactBinaryTree::linkRecurse(const vector<int32_t> & keys, int low, int high,
+                                        const vector<uint32_t> & position) {
+    if (low >= high) {
+        return NONE;
+    }
+    int middle = low + (high - low) / 2;
+    CompactNode & node = this->nodes[position[middle]];
+    node.left = linkRecurse(keys, low, middle, position);
+    node.right = linkRecurse(keys, middle + 1, high, position);
+    return position[middle];
+};
@@ -0,0 +1,73 @@
+/**
+ * @brief Function prototypes for a binary tree of integers in one array.
+ *
+ * Every node lives in a single growable array and refers to its children
+ * by 32 bit index rather than by pointer, so a node is just 12 bytes: the
+ * key and two indices, with no allocator header and no padding. Because no
+ * pointers are stored the whole tree is relocatable, and save and load copy
+ * the array to and from a file as is.
+ *
+ * New nodes go at the end of the array, in allocation order, and deleted
+ * ones are reused. relayout rebuilds the tree balanced and in van Emde Boas
+ * order, where every subtree of a few levels sits in one contiguous run of
+ * the array, so a descent touches few cache lines at every scale.
+ *
+ * Only integer keys are stored. ItemType keys of other kinds are never
+ * found and never inserted.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef COMPACTBINARYTREE_H
+#define COMPACTBINARYTREE_H
+
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ItemType.h"
+
+using std::ostream;
+
+struct CompactNode {
+    int32_t key;
+    uint32_t left;    // index of the left child, or NONE
+    uint32_t right;   // index of the right child, or NONE
+};
+
+class CompactBinaryTree {
+    public:
+        static const uint32_t NONE = 0xFFFFFFFF;
+
+        CompactBinaryTree();
+        int length() const;
+        void insertItem(ItemType & item);
+        void build(std::vector<ItemType> & items);
+        void deleteItem(ItemType & item);
+        void retrieve(ItemType & item, bool & found) const;
+        void clear();
+        void inOrder() const;
+        void relayout();
+        size_t memoryUsed() const;
+        bool save(const std::string & path) const;
+        bool load(const std::string & path);
+        friend ostream & operator<<(ostream & stream, const CompactBinaryTree & tree);
+
+    private:
+        std::vector<CompactNode> nodes;
+        uint32_t root;
+        uint32_t unused;  // first reusable slot, the rest chained through left
+        int count;
+        uint32_t allocate(int32_t key);
+        void collect(std::vector<int32_t> & keys) const;
+        static bool isValid(const std::vector<CompactNode> & nodes, uint32_t root, uint32_t unused, int count);
+        void layout(const std::vector<int32_t> & keys);
+        void layoutRecurse(const std::vector<int32_t> & keys, int low, int high, int levels,
+                           std::vector<uint32_t> & position);
+        void layoutBottoms(const std::vector<int32_t> & keys, int low, int high, int depth, int levels,
+                           std::vector<uint32_t> & position);
+        uint32_t linkRecurse(const std::vector<int32_t> & keys, int low, int high,
+                             const std::vector<uint32_t> & position);
+};
+
+#endif
@@ -0,0 +1,135 @@
+/**
+ * @brief Implementation of the parallel file ingestion pipeline.
+ *
+ * Tokens that aren't valid integers are skipped rather than ending the load,
+ * since a chunk can't know whether an earlier chunk already stopped.
+ *
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include "Ingest.h"
+
+using std::vector;
+
+static const size_t MINIMUM_CHUNK = 1 << 16; // not worth a thread below this
+
+/**
+ * Parses every integer between begin and end, then sorts them.
+ */
+static void parseChunk(const char * begin, const char * end, vector<int> * run) {
+    const char * current = begin;
+
+    while (current < end) {
+        if (isspace((unsigned char) *current)) { // skip whitespace ourselves, so
+            current++;                           // strtol never reads past end
+            continue;
+        }
+        char * next;
+        errno = 0;
+        long value = strtol(current, &next, 10);
+
+        if (next == current) {                   // not a number, skip the token
+            while (current < end && !isspace((unsigned char) *current)) {
+                current++;
+            }
+            continue;
+        }
+        if (errno == 0 && value >= INT_MIN && value <= INT_MAX) {
+            run->push_back((int) value);
+        }
+        current = next;
+    }
+    std::sort(run->begin(), run->end());
+};
+
+/**
+ * Reads the whole file into memory, with a terminating null for strtol.
+ */
+static bool readFile(const char * path, vector<char> & contents) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    char chunk[65536];
+    ssize_t size;
+
+    while ((size = read(fd, chunk, sizeof(chunk))) > 0) {
+        contents.insert(contents.end(), chunk, chunk + size);
+    }
+    close(fd);
+    contents.push_back('\0');
+    return true;
+};
+
+/**
+ * Loads every integer in the file into items, in ascending order. Uses one
+ * worker per hardware thread when threads is 0. Returns false if the file
+ * can't be opened.
+ */
+bool ingestFile(const char * path, vector<ItemType> & items, unsigned int threads) {
+    vector<char> contents;
+    if (!readFile(path, contents)) {
+        return false;
+    }
+    size_t size = contents.size() - 1;
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = (unsigned int) std::min<size_t>(threads, size / MINIMUM_CHUNK + 1);
+
+    vector<size_t> bounds(threads + 1, size);  // chunk i is [bounds[i], bounds[i + 1])
+    bounds[0] = 0;
+    for (unsigned int i = 1; i < threads; ++i) {
+        size_t bound = std::max(bounds[i - 1], size * i / threads);
+        while (bound < size && !isspace((unsigned char) contents[bound])) {
+            bound++;                           // move off the middle of a token
+        }
+        bounds[i] = bound;
+    }
+
+    vector< vector<int> > runs(threads);       // PARSE & SORT
+    vector<std::thread> workers;
+    for (unsigned int i = 0; i < threads; ++i) {
+        workers.push_back(std::thread(parseChunk, &contents[0] + bounds[i],
+                                      &contents[0] + bounds[i + 1], &runs[i]));
+    }
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+
+    typedef std::pair<int, size_t> Head;       // MERGE, smallest run head first
+    std::priority_queue< Head, vector<Head>, std::greater<Head> > heads;
+    vector<size_t> positions(threads, 0);
+    size_t total = 0;
+
+    for (unsigned int i = 0; i < threads; ++i) {
+        total += runs[i].size();
+        if (!runs[i].empty()) {
+            heads.push(Head(runs[i][0], i));
+        }
+    }
+    items.reserve(items.size() + total);
+
+    while (!heads.empty()) {
+        Head head = heads.top();
+        heads.pop();
+        items.push_back(ItemType(head.first));
+
+        if (++positions[head.second] < runs[head.second].size()) {
+            heads.push(Head(runs[head.second][positions[head.second]], head.second));
+        }
+    }
+    return true;
+};
@@ -0,0 +1,20 @@
+/**
+ * @brief Prototype for the parallel file ingestion pipeline.
+ *
+ * The input file is split into chunks on whitespace boundaries, and every
+ * chunk is parsed and sorted on its own worker thread. The sorted runs are
+ * then k-way merged into a single sorted sequence, ready for a linear time
+ * BinaryTree::build instead of one insertItem per value.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <vector>
+#include "ItemType.h"
+
+bool ingestFile(const char * path, std::vector<ItemType> & items, unsigned int threads = 0);
+
+#endif
@@ -1,22 +1,195 @@
 /** 
  * @brief Implementation of ItemType's comparison method.
+ *
+ * Integers are encoded as 4 big endian bytes with the sign bit flipped, so
+ * that negative values sort before positive ones bytewise. Composites are
+ * the encoded tenant followed by the encoded id, and strings are their own
+ * bytes.
+ *
  * @author Jennifer Teissler
  */
 
+#include <cstring>
 #include "ItemType.h"
 
-ItemType::Comparison ItemType::compareTo(ItemType & item) const {
-    if (this->value > item.getValue()) {
+/**
+ * Encodes an integer into 4 bytes that order the same way bytewise.
+ */
+static void encodeInteger(int value, char * bytes) {
+    uint32_t bits = (uint32_t) value ^ 0x80000000u; // flip the sign bit
+    bytes[0] = (char) (bits >> 24);
+    bytes[1] = (char) (bits >> 16);
+    bytes[2] = (char) (bits >> 8);
+    bytes[3] = (char) bits;
+};
+
+static int decodeInteger(const char * bytes) {
+    uint32_t bits = ((uint32_t) (unsigned char) bytes[0] << 24) |
+                    ((uint32_t) (unsigned char) bytes[1] << 16) |
+                    ((uint32_t) (unsigned char) bytes[2] << 8) |
+                     (uint32_t) (unsigned char) bytes[3];
+    return (int) (bits ^ 0x80000000u);
+};
+
+ItemType::ItemType(int value) {
+    char bytes[4];
+    encodeInteger(value, bytes);
+    assign(INTEGER, bytes, 4);
+};
+
+ItemType::ItemType(const std::string & key) {
+    assign(STRING, key.data(), (int) key.size());
+};
+
+ItemType::ItemType(int tenant, int id) {
+    char bytes[8];
+    encodeInteger(tenant, bytes);
+    encodeInteger(id, bytes + 4);
+    assign(COMPOSITE, bytes, 8);
+};
+
+/**
+ * Rebuilds a key from its kind and encoded bytes, as given by getKind,
+ * getBytes and getSize.
+ */
+ItemType::ItemType(Kind kind, const char * bytes, int size) {
+    assign(kind, bytes, size);
+};
+
+ItemType::ItemType(const ItemType & item) {
+    assign((Kind) item.kind, item.getBytes(), item.size);
+};
+
+ItemType::ItemType(ItemType && item) noexcept {
+    take(item);
+};
+
+ItemType & ItemType::operator=(const ItemType & item) {
+    if (this != &item) {
+        release();
+        assign((Kind) item.kind, item.getBytes(), item.size);
+    }
+    return *this;
+};
+
+ItemType & ItemType::operator=(ItemType && item) noexcept {
+    if (this != &item) {
+        release();
+        take(item);
+    }
+    return *this;
+};
+
+ItemType::~ItemType() {
+    release();
+};
+
+ItemType::Comparison ItemType::compareTo(const ItemType & item) const {
+    if (this->kind != item.kind) {     // different kinds, order by kind
+        return this->kind > item.kind ? GREATER : LESSER;
+    }
+    if (this->prefix != item.prefix) { // settled by the inline prefix
+        return this->prefix > item.prefix ? GREATER : LESSER;
+    }
+    uint32_t shorter = this->size < item.size ? this->size : item.size;
+
+    if (shorter > (uint32_t) PREFIX_SIZE) { // compare what the prefix didn't cover
+        int difference = memcmp(getBytes() + PREFIX_SIZE, item.getBytes() + PREFIX_SIZE,
+                                shorter - PREFIX_SIZE);
+        if (difference != 0) {
+            return difference > 0 ? GREATER : LESSER;
+        }
+    }
+    if (this->size > item.size) {
         return GREATER; // this object is valued as greater than the parameter
-    } 
-    else if (this->value < item.getValue()) {
+    }
+    else if (this->size < item.size) {
         return LESSER;  // this object is valued as lesser than the parameter
-    } 
+    }
     else {
         return EQUAL;   // this object is valued as functionally equal to the parameter
     }
 };
 
+/**
+ * Gets the actual data from within the wrapper class. Only meaningful for
+ * integer keys, composites give their id and strings give 0.
+ */
 int ItemType::getValue() const {
-    return this->value; // gets the actual data from within the wrapper class
-}
\ No newline at end of file
+    if (this->kind == INTEGER) {
+        return decodeInteger(getBytes());
+    }
+    if (this->kind == COMPOSITE) {
+        return decodeInteger(getBytes() + 4);
+    }
+    return 0;
+}
+
+ItemType::Kind ItemType::getKind() const {
+    return (Kind) this->kind;
+};
+
+/**
+ * The encoded key, getSize bytes long.
+ */
+const char * ItemType::getBytes() const {
+    return this->size > (uint32_t) INLINE_SIZE ? this->remote : this->local;
+};
+
+int ItemType::getSize() const {
+    return (int) this->size;
+};
+
+std::ostream & operator<<(std::ostream & stream, const ItemType & item) {
+    if (item.kind == ItemType::STRING) {
+        stream.write(item.getBytes(), item.size);
+    }
+    else if (item.kind == ItemType::COMPOSITE) {
+        stream << decodeInteger(item.getBytes()) << ":" << decodeInteger(item.getBytes() + 4);
+    }
+    else {
+        stream << item.getValue();
+    }
+    return stream;
+};
+
+/**
+ * Stores the encoded key, inline if it fits, and fills in the prefix.
+ */
+void ItemType::assign(Kind kind, const char * bytes, int size) {
+    this->kind = (uint8_t) kind;
+    this->size = (uint32_t) size;
+    this->prefix = 0;
+
+    for (int i = 0; i < PREFIX_SIZE; ++i) { // big endian, so the integer
+        this->prefix <<= 8;                 // compare matches memcmp
+        if (i < size) {
+            this->prefix |= (unsigned char) bytes[i];
+        }
+    }
+    if (size > INLINE_SIZE) {
+        this->remote = new char[size];
+        memcpy(this->remote, bytes, size);
+    }
+    else {
+        memcpy(this->local, bytes, size);
+    }
+};
+
+/**
+ * Takes over another key's storage, heap included, leaving it empty.
+ */
+void ItemType::take(ItemType & item) {
+    this->prefix = item.prefix;
+    this->size = item.size;
+    this->kind = item.kind;
+    memcpy(this->local, item.local, INLINE_SIZE); // also carries the remote pointer
+    item.size = 0;                                // so item must not release it
+};
+
+void ItemType::release() {
+    if (this->size > (uint32_t) INLINE_SIZE) {
+        delete[] this->remote;
+    }
+    this->size = 0;
+};
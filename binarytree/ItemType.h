@@ -5,12 +5,23 @@
  * the implementation and design of the binary tree from what type of data
  * it is actually storing.
  *
+ * Keys may be integers, strings, or (tenant, id) composites. Every key is
+ * encoded into bytes that sort the same way as the key itself, and the first
+ * PREFIX_SIZE of those bytes are kept inline as one big endian integer, so
+ * that most comparisons are settled by a single integer compare without
+ * leaving the node. Keys of up to INLINE_SIZE bytes are stored inline too,
+ * only longer strings are kept on the heap.
+ *
  * @author Jennifer Teissler
  */
 
 #ifndef ITEMTYPE_H
 #define ITEMTYPE_H
 
+#include <stdint.h>
+#include <ostream>
+#include <string>
+
 class ItemType {
     public:
         enum Comparison {
@@ -19,12 +30,42 @@ class ItemType {
             GREATER
         };
 
-        explicit ItemType(int value) : value(value) {};
-        Comparison compareTo (ItemType & item) const;
+        enum Kind {        // keys of different kinds order by kind first
+            INTEGER,
+            STRING,
+            COMPOSITE
+        };
+
+        static const int PREFIX_SIZE = 8;
+        static const int INLINE_SIZE = 16;
+
+        explicit ItemType(int value);
+        explicit ItemType(const std::string & key);
+        ItemType(int tenant, int id);
+        ItemType(Kind kind, const char * bytes, int size);
+        ItemType(const ItemType & item);
+        ItemType(ItemType && item) noexcept;
+        ItemType & operator=(const ItemType & item);
+        ItemType & operator=(ItemType && item) noexcept;
+        ~ItemType();
+        Comparison compareTo (const ItemType & item) const;
         int getValue() const;
+        Kind getKind() const;
+        const char * getBytes() const;
+        int getSize() const;
+        friend std::ostream & operator<<(std::ostream & stream, const ItemType & item);
 
     private:
-        int value;
+        uint64_t prefix;   // first PREFIX_SIZE encoded bytes, zero padded
+        uint32_t size;     // length of the encoded key
+        uint8_t kind;
+        union {
+            char local[INLINE_SIZE];
+            char * remote; // only when size > INLINE_SIZE
+        };
+        void assign(Kind kind, const char * bytes, int size);
+        void take(ItemType & item);
+        void release();
 };
 
 #endif
@@ -10,23 +10,35 @@
 
 #include <cstdlib>
 #include "BinaryTree.h"
+#include "Journal.h"
+#include "Ingest.h"
+#include "TaskPool.h"
+#include "Server.h"
+#include "PersistentBinaryTree.h"
 #include <sys/ioctl.h>
 #include <unistd.h>
+#include <atomic>
 #include <string>
+#include <thread>
 #include <iostream>
-#include <fstream>
+#include <vector>
 
 using std::cout;
 using std::cin;
 using std::endl;
 using std::string;
 using std::stoi;
-using std::ifstream;
 
 typedef unsigned short ushort;
 
+void aggregateRange(BinaryTree &, TaskPool &);
+void balanceTree(BinaryTree &);
 void clearTree(BinaryTree &);
 void deleteValue(BinaryTree &);
+void toggleLazyDelete(BinaryTree &);
+void compactTree(BinaryTree &);
+void setFilter(BinaryTree &);
+void toggleSplay(BinaryTree &);
 void listCommands();
 void insertValue(BinaryTree &);
 void printLength(BinaryTree &);
@@ -34,6 +46,10 @@ void printPreOrder(BinaryTree &);
 void printPostOrder(BinaryTree &);
 void printInOrder(BinaryTree &);
 void retrieveValue(BinaryTree &);
+void printStats(BinaryTree &);
+void printShape(BinaryTree &);
+void snapshotReport(BinaryTree &);
+void compactJournal(BinaryTree &, Journal *);
 void information();
 void clearScreen();
 void drawLine();
@@ -42,13 +58,49 @@ int awaitValueInput();
 
 int main(int argc, char * argv[]) {
     BinaryTree tree;        // initialize the tree
+    TaskPool pool;          // one worker per core for parallel aggregates
+    Journal * journal = NULL;
+    const char * journalPath = NULL;
+    const char * socketPath = NULL; // serve the tree instead of reading commands
+    int port = 0;
+    int first = 1;          // index of the first tree argument
     clearScreen();          // setup screen
     drawLine();
     information();
     cout << endl;
 
-    if (argc > 2) {         // attempt to read in elements from arguments
-        for (int i = 1; i < argc; ++i) {
+    while (argc - first > 1) { // options come before any tree arguments
+        string option = argv[first];
+        if (option == "-j") {
+            journalPath = argv[first + 1];
+        }
+        else if (option == "-u") {
+            socketPath = argv[first + 1];
+        }
+        else if (option == "-t") {
+            port = atoi(argv[first + 1]);
+        }
+        else {
+            break;
+        }
+        first += 2;
+    }
+
+    if (journalPath != NULL) { // replay and keep journaling
+        journal = new Journal(journalPath);
+
+        if (journal->isOpen()) {
+            journal->replay(tree);
+            tree.attachJournal(journal);
+            cout << "TREE RESTORED FROM JOURNAL '" << journalPath << "'" << endl << tree << endl;
+        }
+        else {
+            cout << "UNABLE TO OPEN JOURNAL '" << journalPath << "'" << endl;
+        }
+    }
+
+    if (argc - first > 1) { // attempt to read in elements from arguments
+        for (int i = first; i < argc; ++i) {
             try {           // just skip and silently fail any invalid inputs
                 ItemType data(stoi(argv[i]));
                 tree.insertItem(data);
@@ -57,26 +109,40 @@ int main(int argc, char * argv[]) {
         }                   // display loaded arguments (if any)
         cout << "TREE LOADED FROM ARGUMENTS" << endl << tree << endl;
     }
-    else if (argc == 2) {   // attempt to read in elements from file
-        ifstream file;
-        file.open(argv[1]); // open the file
-
-        if (file) {         // check to make sure file opened
-            int input;
-                            // read all elements from file
-            while (file >> input) {
-                ItemType data(input);
-                tree.insertItem(data);
+    else if (argc - first == 1) { // attempt to read in elements from file
+        std::vector<ItemType> items;
+                            // parse and sort the file on every core
+        if (ingestFile(argv[first], items)) {
+            if (tree.length() == 0) {
+                tree.build(items); // empty tree, build it in one pass
+            }
+            else {          // merge into what the journal restored
+                for (size_t i = 0; i < items.size(); ++i) {
+                    tree.insertItem(items[i]);
+                }
             }
         }
-
-        file.close();       // close file and display loaded arguments (if any)
-        cout << "TREE LOADED FROM FILE '" << argv[1] << "'" << endl << tree << endl;
+                            // display loaded arguments (if any)
+        cout << "TREE LOADED FROM FILE '" << argv[first] << "'" << endl << tree << endl;
     }
-    else {                  // no preloading of arguments
+    else if (journal == NULL) { // no preloading of arguments
         cout << "NO TREE LOADED" << endl;
     }
 
+    if (socketPath != NULL || port > 0) { // serve until interrupted
+        Server server(tree, journal);
+        string address = socketPath != NULL ? socketPath : "127.0.0.1:" + std::to_string(port);
+        if (socketPath != NULL ? server.listenUnix(socketPath) : server.listenTcp(port)) {
+            cout << "SERVING TREE ON " << address << ", CTRL-C TO STOP" << endl;
+            server.run();
+        }
+        else {
+            cout << "UNABLE TO LISTEN ON " << address << endl;
+        }
+        delete journal;
+        return EXIT_SUCCESS;
+    }
+
     cout << endl;           // setup screen
     listCommands();
     cout << endl;
@@ -87,14 +153,28 @@ int main(int argc, char * argv[]) {
         cout << "Enter a command letter: ";
                             
         switch(awaitCommandInput()) {
+            case 'a': aggregateRange(tree, pool);
+                      break;
+            case 'b': balanceTree(tree);
+                      break;
             case 'c': clearTree(tree);
                       break;
             case 'd': deleteValue(tree);
                       break;
+            case 'e': toggleLazyDelete(tree);
+                      break;
+            case 'f': setFilter(tree);
+                      break;
+            case 'g': printShape(tree);
+                      break;
             case 'h': listCommands();
                       break;
+            case 'j': compactJournal(tree, journal);
+                      break;
             case 'i': insertValue(tree);
                       break;
+            case 'k': compactTree(tree);
+                      break;
             case 'l': printLength(tree);
                       break;
             case 'p': printPreOrder(tree);
@@ -107,17 +187,56 @@ int main(int argc, char * argv[]) {
                       break;
             case 'r': retrieveValue(tree);
                       break;
+            case 's': printStats(tree);
+                      break;
+            case 'v': snapshotReport(tree);
+                      break;
+            case 'y': toggleSplay(tree);
+                      break;
             case 'z': information();
                       break;
             default:  cout << "Type 'h' for a list of commands." << endl;
         }
+
+        if (journal != NULL) {
+            journal->commit(); // make this command durable before waiting on input
+        }
     }
 
+    delete journal;
     cout << "program exit" << endl;
     drawLine();
     return EXIT_SUCCESS;    // end program
 };
 
+/**
+ * Counts, sums and finds the minimum and maximum of a range of values,
+ * each computed in parallel across the tree's subtrees.
+ */
+void aggregateRange(BinaryTree & tree, TaskPool & pool) {
+    cout << "Enter the lowest value of the range: ";
+    ItemType low(awaitValueInput());
+    cout << "Enter the highest value of the range: ";
+    ItemType high(awaitValueInput());
+    long long count = tree.reduce(low, high, BinaryTree::COUNT, pool);
+
+    cout << "Count   = " << count << endl;
+    cout << "Sum     = " << tree.reduce(low, high, BinaryTree::SUM, pool) << endl;
+    if (count > 0) {
+        cout << "Minimum = " << tree.reduce(low, high, BinaryTree::MINIMUM, pool) << endl;
+        cout << "Maximum = " << tree.reduce(low, high, BinaryTree::MAXIMUM, pool) << endl;
+    }
+}
+
+/**
+ * Executes the rebalance operation on the tree.
+ */
+void balanceTree(BinaryTree & tree) {
+    cout << "Height Before = " << tree.height() << endl;
+    tree.rebalance();
+    cout << "Height After  = " << tree.height() << endl;
+}
+
 /**
  * Executes the clear operation on the tree.
  */
@@ -136,22 +255,67 @@ void deleteValue(BinaryTree & tree) {
     cout << tree << endl;
 }
 
+/**
+ * Switches between deleting nodes straight away and leaving tombstones
+ * to be compacted in batches.
+ */
+void toggleLazyDelete(BinaryTree & tree) {
+    tree.setLazyDelete(!tree.isLazyDelete());
+    cout << "Lazy Delete " << (tree.isLazyDelete() ? "On" : "Off") << endl;
+}
+
+/**
+ * Removes any tombstones left behind by lazy deletes.
+ */
+void compactTree(BinaryTree & tree) {
+    cout << "Tombstones Removed = " << tree.tombstoneCount() << endl;
+    tree.compact();
+}
+
+/**
+ * Puts a Bloom filter in front of retrieve, or takes it away again.
+ */
+void setFilter(BinaryTree & tree) {
+    cout << "Enter the false positive rate as 1 in N (0 to remove the filter): ";
+    int odds = awaitValueInput();
+    tree.setFilter(odds > 1 ? (tree.length() > 1024 ? tree.length() : 1024) : 0, 1.0 / odds);
+    cout << (odds > 1 ? "Filter On" : "Filter Off") << endl;
+}
+
+/**
+ * Switches between a fixed shape and moving retrieved values to the root.
+ */
+void toggleSplay(BinaryTree & tree) {
+    tree.setSplay(!tree.isSplaying());
+    cout << "Splay Mode " << (tree.isSplaying() ? "On" : "Off") << endl;
+}
+
 /**
  * Displays a help screen.
  * Lists commands, as well as providing info on chained commands.
  */
 void listCommands() {
     cout << "\e[1m[COMMANDS]\e[0m" << endl;
+    cout << "[a] Aggregate Range" << endl;
+    cout << "[b] Balance Tree" << endl;
     cout << "[c] Clear Tree" << endl;
     cout << "[d] Delete Value" << endl;
+    cout << "[e] Toggle Lazy Delete" << endl;
+    cout << "[f] Set Membership Filter" << endl;
+    cout << "[g] Print Tree Shape" << endl;
     cout << "[h] List Commands" << endl;
     cout << "[i] Insert Value" << endl;
+    cout << "[j] Compact Journal" << endl;
+    cout << "[k] Compact Tombstones" << endl;
     cout << "[l] Print Length" << endl;
     cout << "[n] Print Tree In Order" << endl;
     cout << "[o] Print Tree Post Order" << endl;
     cout << "[p] Print Tree Pre Order" << endl;
     cout << "[q] Quit Program" << endl;
     cout << "[r] Retrieve Value" << endl;
+    cout << "[s] Print Statistics" << endl;
+    cout << "[v] Snapshot Report" << endl;
+    cout << "[y] Toggle Splay Mode" << endl;
     cout << "[z] Information" << endl << endl;
     cout << "\e[1m[Note]\e[0m Commands may be chained together for complex operations." << endl;
     cout << "       While running chained commands, input sanitization and " << endl;
@@ -169,6 +333,21 @@ void insertValue(BinaryTree & tree) {
     cout << tree << endl;
 }
 
+/**
+ * Folds the journal into a fresh snapshot of the tree.
+ */
+void compactJournal(BinaryTree & tree, Journal * journal) {
+    if (journal == NULL) {
+        cout << "No Journal, start with './main -j [journal]'" << endl;
+    }
+    else if (journal->compact(tree)) {
+        cout << "Journal Compacted" << endl;
+    }
+    else {
+        cout << "Journal Compaction Failed" << endl;
+    }
+}
+
 /**
  * Retrieves the length of the tree.
  */
@@ -215,6 +394,89 @@ void retrieveValue(BinaryTree & tree) {
     }
 }
 
+/**
+ * Prints the hot-path counters collected by the tree, then resets them so
+ * that the next snapshot only covers the operations in between.
+ */
+void printStats(BinaryTree & tree) {
+    TreeStats stats = tree.stats();
+#ifndef TREE_STATS
+    cout << "Statistics disabled, rebuild with 'make stats'" << endl;
+#endif
+    cout << "Comparisons   = " << stats.comparisons << endl;
+    cout << "Nodes Visited = " << stats.visits << endl;
+    cout << "Max Depth     = " << stats.maxDepth << endl;
+    cout << "Allocations   = " << stats.allocations << endl;
+    cout << "Deallocations = " << stats.deallocations << endl;
+
+    FilterStats filter = tree.filterStats();
+    if (filter.counters > 0) {
+        cout << "Filter Size   = " << filter.counters << " counters, " << filter.hashes << " hashes" << endl;
+        cout << "Filter Probes = " << filter.queries << ", " << filter.rejections << " rejected, "
+             << filter.falsePositives << " false positives" << endl;
+        cout << "FP Rate       = " << filter.observedRate << " observed, "
+             << filter.estimatedRate << " expected, " << filter.configuredRate << " configured" << endl;
+    }
+    tree.resetStats();
+}
+
+/**
+ * Prints the height, average depth and number of nodes on each level.
+ */
+void printShape(BinaryTree & tree) {
+    std::vector<int> histogram = tree.depthHistogram();
+    cout << "Tree Height   = " << tree.height() << endl;
+    cout << "Average Depth = " << tree.averageDepth() << endl;
+
+    for (size_t i = 0; i < histogram.size(); ++i) {
+        cout << "Level " << i << " = " << histogram[i] << endl;
+    }
+}
+
+/**
+ * Reports on a snapshot of a persistent copy of the tree while a writer
+ * keeps deleting every value from the copy and putting it back. The report
+ * reads only the version it was started on, so it neither waits for the
+ * writer nor sees any of its changes.
+ */
+void snapshotReport(BinaryTree & tree) {
+    std::vector<ItemType> items;
+    tree.collect(items);
+    PersistentBinaryTree copy;
+    for (size_t i = 0; i < items.size(); ++i) {
+        copy.insertItem(items[i]);
+    }
+    PersistentBinaryTree::Snapshot snapshot = copy.snapshot();
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        for (size_t i = 0; !done && !items.empty(); i = (i + 1) % items.size()) {
+            ItemType item = items[i];
+            copy.deleteItem(item);
+            copy.insertItem(item);
+        }
+    });
+
+    std::vector<ItemType> reported;
+    bool overlapped = items.empty();        // report until a write has landed meanwhile
+    for (int pass = 0; pass < 100 || !overlapped; ++pass) {
+        overlapped = overlapped || copy.snapshot().version() != snapshot.version();
+        reported.clear();
+        snapshot.collect(reported);
+    }
+    done = true;
+    writer.join();
+
+    bool unchanged = (int) reported.size() == snapshot.length() && reported.size() == items.size();
+    for (size_t i = 0; unchanged && i < items.size(); ++i) {
+        unchanged = reported[i].compareTo(items[i]) == ItemType::EQUAL;
+    }
+    cout << "Snapshot Version = " << snapshot.version() << endl;
+    cout << "Writes Meanwhile = " << copy.snapshot().version() - snapshot.version() << endl;
+    cout << "Snapshot Height  = " << snapshot.height() << endl;
+    cout << "Snapshot Length  = " << snapshot.length() << endl;
+    cout << "Report " << (unchanged ? "Matches Tree" : "Does Not Match Tree") << endl;
+}
+
 /**
  * Provides basic information about the program.
  */
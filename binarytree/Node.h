@@ -13,7 +13,8 @@ struct Node {
     ItemType item;
     Node * left;
     Node * right;
-    explicit Node(ItemType & item) : item(item), left(NULL), right(NULL) {};  
+    bool deleted; // tombstone, left in place by a lazy delete
+    explicit Node(ItemType & item) : item(item), left(NULL), right(NULL), deleted(false) {};  
 };
 
 #endif
@@ -0,0 +1,265 @@
+/**
+ * @brief Function implementations for the persistent binary tree.
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include "PersistentBinaryTree.h"
+
+using std::cout;
+using std::endl;
+using std::ostream;
+using std::vector;
+
+/**
+ * Appends the items below node that lie between low and high, in order.
+ * Either bound may be NULL for no bound on that side.
+ */
+static void collectRecurse(const PersistentNode * node, const ItemType * low, const ItemType * high,
+                           vector<ItemType> & items) {
+    if (node == NULL) {
+        return;
+    }
+    bool aboveLow = low == NULL || low->compareTo(node->item) != ItemType::GREATER;
+    bool belowHigh = high == NULL || high->compareTo(node->item) != ItemType::LESSER;
+    if (aboveLow) {
+        collectRecurse(node->left.get(), low, high, items);
+    }
+    if (aboveLow && belowHigh) {
+        items.push_back(node->item);
+    }
+    if (belowHigh) {
+        collectRecurse(node->right.get(), low, high, items);
+    }
+}
+
+PersistentBinaryTree::PersistentBinaryTree() {
+    this->current = std::shared_ptr<const Snapshot>(new Snapshot());
+};
+
+int PersistentBinaryTree::length() const {
+    return snapshot().length();
+};
+
+void PersistentBinaryTree::insertItem(ItemType & item) {
+    std::lock_guard<std::mutex> locked(this->writer);
+    bool inserted = false;
+    PersistentLink root = insertRecurse(this->current->root, item, inserted);
+    if (inserted) {
+        publish(root, this->current->count + 1);
+    }
+};
+
+void PersistentBinaryTree::deleteItem(ItemType & item) {
+    std::lock_guard<std::mutex> locked(this->writer);
+    bool removed = false;
+    PersistentLink root = deleteRecurse(this->current->root, item, removed);
+    if (removed) {
+        publish(root, this->current->count - 1);
+    }
+};
+
+void PersistentBinaryTree::retrieve(ItemType & item, bool & found) const {
+    snapshot().retrieve(item, found);
+};
+
+/**
+ * Publishes an empty version. Nodes still held by older snapshots are kept
+ * until those are released.
+ */
+void PersistentBinaryTree::clear() {
+    std::lock_guard<std::mutex> locked(this->writer);
+    publish(PersistentLink(), 0);
+};
+
+void PersistentBinaryTree::inOrder() const {
+    cout << *this << endl;
+};
+
+/**
+ * The latest version, which stays readable and unchanged for as long as
+ * the snapshot is kept.
+ */
+PersistentBinaryTree::Snapshot PersistentBinaryTree::snapshot() const {
+    return *std::atomic_load(&this->current);
+};
+
+ostream & operator<<(ostream & stream, const PersistentBinaryTree & tree) {
+    return stream << tree.snapshot();
+};
+
+/**
+ * Makes root the latest version. Called with the writer lock held, so the
+ * version read here is the one the change was made against.
+ */
+void PersistentBinaryTree::publish(const PersistentLink & root, int count) {
+    std::shared_ptr<const Snapshot> next(new Snapshot(root, count, this->current->number + 1));
+    std::atomic_store(&this->current, next);
+};
+
+static int height(const PersistentLink & node) {
+    return node != NULL ? node->height : 0;
+}
+
+/**
+ * Returns the subtree with item added, copying node and its descendants on
+ * the way down to the new leaf, and rebalancing the copies on the way back
+ * up. If item is already there, node itself is returned and inserted stays
+ * false.
+ */
+PersistentLink PersistentBinaryTree::insertRecurse(const PersistentLink & node, ItemType & item, bool & inserted) {
+    if (node == NULL) {
+        inserted = true;
+        return std::make_shared<const PersistentNode>(item, PersistentLink(), PersistentLink());
+    }
+    ItemType::Comparison comparison = item.compareTo(node->item);
+    if (comparison == ItemType::EQUAL) {
+        return node;                       // duplicate, nothing inserted
+    }
+    if (comparison == ItemType::LESSER) {
+        PersistentLink left = insertRecurse(node->left, item, inserted);
+        return inserted ? balance(node->item, left, node->right) : node;
+    }
+    PersistentLink right = insertRecurse(node->right, item, inserted);
+    return inserted ? balance(node->item, node->left, right) : node;
+};
+
+/**
+ * Returns the subtree with item removed, copying the path down to it. A
+ * node with two children is replaced by a copy of its in order successor,
+ * which copies the path down to the successor too.
+ */
+PersistentLink PersistentBinaryTree::deleteRecurse(const PersistentLink & node, ItemType & item, bool & removed) {
+    if (node == NULL) {
+        return node;                       // not in the tree
+    }
+    ItemType::Comparison comparison = item.compareTo(node->item);
+    if (comparison == ItemType::LESSER) {
+        PersistentLink left = deleteRecurse(node->left, item, removed);
+        return removed ? balance(node->item, left, node->right) : node;
+    }
+    if (comparison == ItemType::GREATER) {
+        PersistentLink right = deleteRecurse(node->right, item, removed);
+        return removed ? balance(node->item, node->left, right) : node;
+    }
+    removed = true;
+    if (node->left == NULL) {
+        return node->right;
+    }
+    if (node->right == NULL) {
+        return node->left;
+    }
+    const PersistentNode * successor = NULL;
+    PersistentLink right = removeMinimum(node->right, successor);
+    return balance(successor->item, node->left, right);
+};
+
+/**
+ * Returns the subtree without its smallest node, which is left in minimum.
+ * The node itself lives on in the version being replaced.
+ */
+PersistentLink PersistentBinaryTree::removeMinimum(const PersistentLink & node,
+                                                   const PersistentNode * & minimum) {
+    if (node->left == NULL) {
+        minimum = node.get();
+        return node->right;
+    }
+    PersistentLink left = removeMinimum(node->left, minimum);
+    return balance(node->item, left, node->right);
+};
+
+/**
+ * Builds a node for item over left and right, subtrees whose heights
+ * differ by at most two, rotating once or twice if they differ by two so
+ * the result is balanced again. Only the new nodes are built; the
+ * grandchildren are shared as they are.
+ */
+PersistentLink PersistentBinaryTree::balance(const ItemType & item, const PersistentLink & left,
+                                             const PersistentLink & right) {
+    if (height(left) > height(right) + 1) {           // left heavy
+        if (height(left->left) >= height(left->right)) {
+            return std::make_shared<const PersistentNode>(left->item, left->left,
+                       std::make_shared<const PersistentNode>(item, left->right, right));
+        }
+        const PersistentLink & middle = left->right; // left's right side is the taller
+        return std::make_shared<const PersistentNode>(middle->item,
+                   std::make_shared<const PersistentNode>(left->item, left->left, middle->left),
+                   std::make_shared<const PersistentNode>(item, middle->right, right));
+    }
+    if (height(right) > height(left) + 1) {           // right heavy, the mirror image
+        if (height(right->right) >= height(right->left)) {
+            return std::make_shared<const PersistentNode>(right->item,
+                       std::make_shared<const PersistentNode>(item, left, right->left), right->right);
+        }
+        const PersistentLink & middle = right->left;
+        return std::make_shared<const PersistentNode>(middle->item,
+                   std::make_shared<const PersistentNode>(item, left, middle->left),
+                   std::make_shared<const PersistentNode>(right->item, middle->right, right->right));
+    }
+    return std::make_shared<const PersistentNode>(item, left, right);
+};
+
+PersistentBinaryTree::Snapshot::Snapshot() {
+    this->count = 0;
+    this->number = 0;
+};
+
+int PersistentBinaryTree::Snapshot::length() const {
+    return this->count;
+};
+
+/**
+ * How many writes were published before this version, so that two
+ * snapshots can be told apart.
+ */
+uint64_t PersistentBinaryTree::Snapshot::version() const {
+    return this->number;
+};
+
+int PersistentBinaryTree::Snapshot::height() const {
+    return this->root != NULL ? this->root->height : 0;
+};
+
+void PersistentBinaryTree::Snapshot::retrieve(ItemType & item, bool & found) const {
+    const PersistentNode * node = this->root.get();
+    found = false;
+
+    while (node != NULL && !found) {
+        ItemType::Comparison comparison = item.compareTo(node->item);
+        found = comparison == ItemType::EQUAL;
+        node = comparison == ItemType::LESSER ? node->left.get() : node->right.get();
+    }
+};
+
+void PersistentBinaryTree::Snapshot::collect(vector<ItemType> & items) const {
+    collectRecurse(this->root.get(), NULL, NULL, items);
+};
+
+/**
+ * Appends every item from low to high inclusive to items, in order. Only
+ * subtrees that can overlap the range are visited.
+ */
+void PersistentBinaryTree::Snapshot::range(ItemType & low, ItemType & high, vector<ItemType> & items) const {
+    collectRecurse(this->root.get(), &low, &high, items);
+};
+
+void PersistentBinaryTree::Snapshot::inOrder() const {
+    cout << *this << endl;
+};
+
+/**
+ * Lets go of this version. Nodes no other version shares are freed.
+ */
+void PersistentBinaryTree::Snapshot::release() {
+    this->root.reset();
+    this->count = 0;
+};
+
+ostream & operator<<(ostream & stream, const PersistentBinaryTree::Snapshot & snapshot) {
+    vector<ItemType> items;
+    snapshot.collect(items);
+    for (size_t i = 0; i < items.size(); ++i) {
+        stream << items[i] << " ";
+    }
+    return stream;
+};
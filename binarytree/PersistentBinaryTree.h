@@ -0,0 +1,78 @@
+/**
+ * @brief Function prototypes for a persistent binary tree.
+ *
+ * Nodes are never changed in place. An insert or delete copies just the
+ * nodes on the path from the root down to the change, shares every other
+ * node with the version before it, and then publishes the new root with a
+ * single atomic store. The tree is kept balanced as an AVL tree, so that
+ * path, and the rotations that rebalance it, are O(log n) nodes whatever
+ * order items arrive in. A Snapshot holds one version and reads exactly that
+ * version for as long as it is kept, however many writes come after it.
+ * Long reports can therefore walk a consistent tree without copying it and
+ * without blocking writers.
+ *
+ * Nodes are reference counted. Those a newer version no longer shares are
+ * freed when the last snapshot holding them is released. Writers take turns
+ * on a lock, and readers never take it.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef PERSISTENTBINARYTREE_H
+#define PERSISTENTBINARYTREE_H
+
+#include <stdint.h>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "PersistentNode.h"
+
+using std::ostream;
+
+class PersistentBinaryTree {
+    public:
+        class Snapshot {
+            public:
+                Snapshot();
+                int length() const;
+                uint64_t version() const;
+                int height() const;
+                void retrieve(ItemType & item, bool & found) const;
+                void collect(std::vector<ItemType> & items) const;
+                void range(ItemType & low, ItemType & high, std::vector<ItemType> & items) const;
+                void inOrder() const;
+                void release();
+                friend ostream & operator<<(ostream & stream, const Snapshot & snapshot);
+
+            private:
+                friend class PersistentBinaryTree;
+                PersistentLink root;
+                int count;
+                uint64_t number;   // writes published before this version
+                Snapshot(const PersistentLink & root, int count, uint64_t number)
+                    : root(root), count(count), number(number) {};
+        };
+
+        PersistentBinaryTree();
+        int length() const;
+        void insertItem(ItemType & item);
+        void deleteItem(ItemType & item);
+        void retrieve(ItemType & item, bool & found) const;
+        void clear();
+        void inOrder() const;
+        Snapshot snapshot() const;
+        friend ostream & operator<<(ostream & stream, const PersistentBinaryTree & tree);
+
+    private:
+        std::shared_ptr<const Snapshot> current; // latest version, read and written atomically
+        std::mutex writer;
+        void publish(const PersistentLink & root, int count);
+        static PersistentLink insertRecurse(const PersistentLink & node, ItemType & item, bool & inserted);
+        static PersistentLink deleteRecurse(const PersistentLink & node, ItemType & item, bool & removed);
+        static PersistentLink removeMinimum(const PersistentLink & node, const PersistentNode * & minimum);
+        static PersistentLink balance(const ItemType & item, const PersistentLink & left,
+                                      const PersistentLink & right);
+};
+
+#endif
@@ -0,0 +1,32 @@
+/**
+ * @brief Defines the structure of a node in the persistent binary tree.
+ *
+ * Nodes are never changed once built, so any number of tree versions can
+ * share them. Each node is freed when the last version holding it goes.
+ * A node records the height of its subtree, which keeps the tree balanced.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef PERSISTENTNODE_H
+#define PERSISTENTNODE_H
+
+#include <algorithm>
+#include <memory>
+#include "ItemType.h"
+
+struct PersistentNode;
+
+typedef std::shared_ptr<const PersistentNode> PersistentLink;
+
+struct PersistentNode {
+    const ItemType item;
+    const PersistentLink left;
+    const PersistentLink right;
+    const int height;             // levels in this subtree, 1 for a leaf
+    PersistentNode(const ItemType & item, const PersistentLink & left, const PersistentLink & right)
+        : item(item), left(left), right(right),
+          height(1 + std::max(left ? left->height : 0, right ? right->height : 0)) {};
+};
+
+#endif
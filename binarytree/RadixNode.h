@@ -0,0 +1,61 @@
+/**
+ * @brief Defines the inner nodes of the adaptive radix tree.
+ *
+ * An inner node maps the next key byte to a child. It comes in four sizes,
+ * and is swapped for the next size up or down as children come and go.
+ * Every child pointer is either another inner node or, with its low bit set,
+ * a leaf that carries the whole key in the pointer itself.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef RADIXNODE_H
+#define RADIXNODE_H
+
+#include <stdint.h>
+#include <cstring>
+
+struct RadixNode {
+    enum Type {
+        NODE4,
+        NODE16,
+        NODE48,
+        NODE256
+    };
+
+    uint8_t type;
+    uint16_t count;   // children in use
+    explicit RadixNode(Type type) : type(type), count(0) {};
+};
+
+struct RadixNode4 : RadixNode {
+    uint8_t keys[4];              // sorted
+    RadixNode * children[4];
+    RadixNode4() : RadixNode(NODE4) {};
+};
+
+struct RadixNode16 : RadixNode {
+    uint8_t keys[16];             // sorted, and searched 16 at a time
+    RadixNode * children[16];
+    RadixNode16() : RadixNode(NODE16) {
+        memset(this->keys, 0, sizeof(this->keys));
+    };
+};
+
+struct RadixNode48 : RadixNode {
+    uint8_t index[256];           // slot + 1 of the child for each byte, 0 if none
+    RadixNode * children[48];
+    RadixNode48() : RadixNode(NODE48) {
+        memset(this->index, 0, sizeof(this->index));
+        memset(this->children, 0, sizeof(this->children));
+    };
+};
+
+struct RadixNode256 : RadixNode {
+    RadixNode * children[256];    // NULL if none
+    RadixNode256() : RadixNode(NODE256) {
+        memset(this->children, 0, sizeof(this->children));
+    };
+};
+
+#endif
@@ -0,0 +1,520 @@
+/**
+ * @brief Function implementations for the adaptive radix tree.
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include "RadixTree.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using std::cout;
+using std::endl;
+using std::ostream;
+using std::vector;
+
+static_assert(sizeof(uintptr_t) > sizeof(uint32_t), "leaves are packed into pointers");
+
+/**
+ * Keys are stored with the sign bit flipped, so that negative keys come
+ * first when the bytes are compared as unsigned.
+ */
+static uint32_t encode(int value) {
+    return (uint32_t) value ^ 0x80000000u;
+}
+
+static int decode(uint32_t key) {
+    return (int) (key ^ 0x80000000u);
+}
+
+static uint8_t keyByte(uint32_t key, int depth) {
+    return (uint8_t) (key >> (24 - 8 * depth));
+}
+
+static bool isLeaf(const RadixNode * node) {
+    return ((uintptr_t) node & 1) != 0;
+}
+
+static RadixNode * makeLeaf(uint32_t key) {
+    return (RadixNode *) (((uintptr_t) key << 1) | 1);
+}
+
+static uint32_t leafKey(const RadixNode * node) {
+    return (uint32_t) ((uintptr_t) node >> 1);
+}
+
+/**
+ * Adds a child to a node that keeps its bytes sorted, shifting the larger
+ * ones up a slot.
+ */
+template <typename Node>
+static void insertSorted(Node * node, uint8_t byte, RadixNode * child) {
+    int position = node->count;
+    while (position > 0 && node->keys[position - 1] > byte) {
+        node->keys[position] = node->keys[position - 1];
+        node->children[position] = node->children[position - 1];
+        position--;
+    }
+    node->keys[position] = byte;
+    node->children[position] = child;
+    node->count++;
+}
+
+template <typename Node>
+static void removeSorted(Node * node, uint8_t byte) {
+    int position = 0;
+    while (node->keys[position] != byte) {
+        position++;
+    }
+    for (int i = position + 1; i < node->count; ++i) {
+        node->keys[i - 1] = node->keys[i];
+        node->children[i - 1] = node->children[i];
+    }
+    node->count--;
+}
+
+RadixTree::RadixTree() {
+    this->count = 0;
+    this->root = NULL;
+};
+
+RadixTree::~RadixTree() {
+    clear();
+};
+
+int RadixTree::length() const {
+    return this->count;
+};
+
+void RadixTree::insertItem(ItemType & item) {
+    if (item.getKind() == ItemType::INTEGER && insert(this->root, encode(item.getValue()), 0)) {
+        this->count++;
+    }
+};
+
+void RadixTree::deleteItem(ItemType & item) {
+    if (item.getKind() == ItemType::INTEGER && remove(this->root, encode(item.getValue()), 0)) {
+        this->count--;
+    }
+};
+
+void RadixTree::retrieve(ItemType & item, bool & found) const {
+    found = false;
+    if (item.getKind() != ItemType::INTEGER) {
+        return;
+    }
+    uint32_t key = encode(item.getValue());
+    RadixNode * node = this->root;
+
+    for (int depth = 0; node != NULL && !isLeaf(node); ++depth) {
+        RadixNode ** child = findChild(node, keyByte(key, depth));
+        node = child != NULL ? *child : NULL;
+    }
+    found = node != NULL && leafKey(node) == key;
+};
+
+/**
+ * Appends every item from low to high, inclusive, in order. Only the
+ * children whose keys can fall in the range are visited.
+ */
+void RadixTree::range(ItemType & low, ItemType & high, vector<ItemType> & items) const {
+    if (low.getKind() != ItemType::INTEGER) {
+        return;                            // every other kind sorts after the integers
+    }
+    uint32_t first = encode(low.getValue());
+    uint32_t last = high.getKind() == ItemType::INTEGER ? encode(high.getValue()) : 0xFFFFFFFFu;
+    if (first > last) {
+        return;
+    }
+    vector<int> keys;
+    visit(this->root, 0, 0, first, last, keys);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        items.push_back(ItemType(keys[i]));
+    }
+};
+
+void RadixTree::clear() {
+    destroy(this->root);
+    this->root = NULL;
+    this->count = 0;
+};
+
+void RadixTree::inOrder() const {
+    cout << *this << endl;
+};
+
+/**
+ * Bytes held by the inner nodes. Leaves live in their parents' pointers.
+ */
+size_t RadixTree::memoryUsed() const {
+    return memoryRecurse(this->root);
+};
+
+ostream & operator<<(ostream & stream, const RadixTree & tree) {
+    vector<int> keys;
+    tree.visit(tree.root, 0, 0, 0, 0xFFFFFFFFu, keys);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        stream << keys[i] << " ";
+    }
+    return stream;
+};
+
+/**
+ * Adds key below node, which is reached by the key's bytes before depth.
+ * Returns false if the key was already there.
+ */
+bool RadixTree::insert(RadixNode *& node, uint32_t key, int depth) {
+    if (node == NULL) {
+        node = makeLeaf(key);
+        return true;
+    }
+    if (isLeaf(node)) {
+        uint32_t existing = leafKey(node);
+        if (existing == key) {
+            return false;                  // duplicate, nothing inserted
+        }
+        RadixNode * leaf = node;
+        RadixNode ** slot = &node;
+        while (keyByte(existing, depth) == keyByte(key, depth)) { // one node per shared byte
+            RadixNode4 * chain = new RadixNode4();
+            chain->keys[0] = keyByte(key, depth);
+            chain->children[0] = NULL;
+            chain->count = 1;
+            *slot = chain;
+            slot = &chain->children[0];
+            depth++;
+        }
+        *slot = new RadixNode4();          // then one where the two keys part
+        addChild(*slot, keyByte(existing, depth), leaf);
+        addChild(*slot, keyByte(key, depth), makeLeaf(key));
+        return true;
+    }
+    RadixNode ** child = findChild(node, keyByte(key, depth));
+    if (child != NULL) {
+        return insert(*child, key, depth + 1);
+    }
+    addChild(node, keyByte(key, depth), makeLeaf(key));
+    return true;
+};
+
+/**
+ * Removes key from below node. A node left holding a single leaf is
+ * replaced by that leaf, so every inner node still parts two keys.
+ * Returns false if the key wasn't there.
+ */
+bool RadixTree::remove(RadixNode *& node, uint32_t key, int depth) {
+    if (node == NULL) {
+        return false;
+    }
+    if (isLeaf(node)) {
+        if (leafKey(node) != key) {
+            return false;
+        }
+        node = NULL;
+        return true;
+    }
+    uint8_t byte = keyByte(key, depth);
+    RadixNode ** child = findChild(node, byte);
+    if (child == NULL) {
+        return false;                      // not in the tree
+    }
+    if (isLeaf(*child)) {
+        if (leafKey(*child) != key) {
+            return false;
+        }
+        removeChild(node, byte);
+    }
+    else if (!remove(*child, key, depth + 1)) {
+        return false;
+    }
+
+    if (node->type == RadixNode::NODE4 && node->count == 1) {
+        RadixNode4 * single = static_cast<RadixNode4 *>(node);
+        if (isLeaf(single->children[0])) {
+            node = single->children[0];
+            delete single;
+        }
+    }
+    return true;
+};
+
+/**
+ * Appends the keys below node that lie in [low, high], in order. Every key
+ * below node starts with prefix, which holds the bytes before depth.
+ */
+void RadixTree::visit(const RadixNode * node, uint32_t prefix, int depth, uint32_t low, uint32_t high,
+                      vector<int> & keys) const {
+    if (node == NULL) {
+        return;
+    }
+    if (isLeaf(node)) {
+        uint32_t key = leafKey(node);
+        if (key >= low && key <= high) {
+            keys.push_back(decode(key));
+        }
+        return;
+    }
+    uint8_t bytes[256];
+    RadixNode * children[256];
+    int size = listChildren(node, bytes, children);
+    int shift = 24 - 8 * depth;
+
+    for (int i = 0; i < size; ++i) {
+        uint32_t first = prefix | ((uint32_t) bytes[i] << shift);
+        uint32_t last = first | ((1u << shift) - 1);
+        if (last < low) {
+            continue;
+        }
+        if (first > high) {
+            break;
+        }
+        visit(children[i], first, depth + 1, low, high, keys);
+    }
+};
+
+/**
+ * Fills bytes and children with the node's children in byte order, and
+ * returns how many there are.
+ */
+int RadixTree::listChildren(const RadixNode * node, uint8_t * bytes, RadixNode ** children) {
+    int size = 0;
+    switch (node->type) {
+        case RadixNode::NODE4: {
+            const RadixNode4 * small = static_cast<const RadixNode4 *>(node);
+            for (; size < small->count; ++size) {
+                bytes[size] = small->keys[size];
+                children[size] = small->children[size];
+            }
+            break;
+        }
+        case RadixNode::NODE16: {
+            const RadixNode16 * medium = static_cast<const RadixNode16 *>(node);
+            for (; size < medium->count; ++size) {
+                bytes[size] = medium->keys[size];
+                children[size] = medium->children[size];
+            }
+            break;
+        }
+        case RadixNode::NODE48: {
+            const RadixNode48 * large = static_cast<const RadixNode48 *>(node);
+            for (int byte = 0; byte < 256; ++byte) {
+                if (large->index[byte] != 0) {
+                    bytes[size] = (uint8_t) byte;
+                    children[size++] = large->children[large->index[byte] - 1];
+                }
+            }
+            break;
+        }
+        default: {
+            const RadixNode256 * full = static_cast<const RadixNode256 *>(node);
+            for (int byte = 0; byte < 256; ++byte) {
+                if (full->children[byte] != NULL) {
+                    bytes[size] = (uint8_t) byte;
+                    children[size++] = full->children[byte];
+                }
+            }
+        }
+    }
+    return size;
+};
+
+/**
+ * The slot holding the child for byte, or NULL if there is none.
+ */
+RadixNode ** RadixTree::findChild(RadixNode * node, uint8_t byte) {
+    switch (node->type) {
+        case RadixNode::NODE4: {
+            RadixNode4 * small = static_cast<RadixNode4 *>(node);
+            for (int i = 0; i < small->count; ++i) {
+                if (small->keys[i] == byte) {
+                    return &small->children[i];
+                }
+            }
+            return NULL;
+        }
+        case RadixNode::NODE16: {
+            RadixNode16 * medium = static_cast<RadixNode16 *>(node);
+#ifdef __SSE2__
+            __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8((char) byte),             // all 16 bytes
+                                             _mm_loadu_si128((const __m128i *) medium->keys)); // at once
+            unsigned mask = (unsigned) _mm_movemask_epi8(matches) & ((1u << medium->count) - 1);
+            return mask != 0 ? &medium->children[__builtin_ctz(mask)] : NULL;
+#else
+            for (int i = 0; i < medium->count; ++i) {
+                if (medium->keys[i] == byte) {
+                    return &medium->children[i];
+                }
+            }
+            return NULL;
+#endif
+        }
+        case RadixNode::NODE48: {
+            RadixNode48 * large = static_cast<RadixNode48 *>(node);
+            return large->index[byte] != 0 ? &large->children[large->index[byte] - 1] : NULL;
+        }
+        default: {
+            RadixNode256 * full = static_cast<RadixNode256 *>(node);
+            return full->children[byte] != NULL ? &full->children[byte] : NULL;
+        }
+    }
+};
+
+/**
+ * Adds a child for byte, which the node must not have yet, first moving up
+ * to the next node size if this one is full.
+ */
+void RadixTree::addChild(RadixNode *& node, uint8_t byte, RadixNode * child) {
+    if ((node->type == RadixNode::NODE4 && node->count == 4) ||
+        (node->type == RadixNode::NODE16 && node->count == 16) ||
+        (node->type == RadixNode::NODE48 && node->count == 48)) {
+        grow(node);
+    }
+    switch (node->type) {
+        case RadixNode::NODE4:
+            insertSorted(static_cast<RadixNode4 *>(node), byte, child);
+            break;
+        case RadixNode::NODE16:
+            insertSorted(static_cast<RadixNode16 *>(node), byte, child);
+            break;
+        case RadixNode::NODE48: {
+            RadixNode48 * large = static_cast<RadixNode48 *>(node);
+            int slot = 0;
+            while (large->children[slot] != NULL) {    // first slot freed or never used
+                slot++;
+            }
+            large->children[slot] = child;
+            large->index[byte] = (uint8_t) (slot + 1);
+            large->count++;
+            break;
+        }
+        default:
+            static_cast<RadixNode256 *>(node)->children[byte] = child;
+            node->count++;
+    }
+};
+
+/**
+ * Drops the child for byte, then moves down to the next node size once the
+ * children fit in it with some room to spare.
+ */
+void RadixTree::removeChild(RadixNode *& node, uint8_t byte) {
+    switch (node->type) {
+        case RadixNode::NODE4:
+            removeSorted(static_cast<RadixNode4 *>(node), byte);
+            break;
+        case RadixNode::NODE16:
+            removeSorted(static_cast<RadixNode16 *>(node), byte);
+            break;
+        case RadixNode::NODE48: {
+            RadixNode48 * large = static_cast<RadixNode48 *>(node);
+            large->children[large->index[byte] - 1] = NULL;
+            large->index[byte] = 0;
+            large->count--;
+            break;
+        }
+        default:
+            static_cast<RadixNode256 *>(node)->children[byte] = NULL;
+            node->count--;
+    }
+    if ((node->type == RadixNode::NODE16 && node->count <= 3) ||
+        (node->type == RadixNode::NODE48 && node->count <= 12) ||
+        (node->type == RadixNode::NODE256 && node->count <= 40)) {
+        shrink(node);
+    }
+};
+
+void RadixTree::grow(RadixNode *& node) {
+    uint8_t bytes[256];
+    RadixNode * children[256];
+    int size = listChildren(node, bytes, children);
+    RadixNode * bigger;
+
+    if (node->type == RadixNode::NODE4) {
+        bigger = new RadixNode16();
+    }
+    else if (node->type == RadixNode::NODE16) {
+        bigger = new RadixNode48();
+    }
+    else {
+        bigger = new RadixNode256();
+    }
+    release(node);
+    node = bigger;
+    for (int i = 0; i < size; ++i) {
+        addChild(node, bytes[i], children[i]);
+    }
+};
+
+void RadixTree::shrink(RadixNode *& node) {
+    uint8_t bytes[256];
+    RadixNode * children[256];
+    int size = listChildren(node, bytes, children);
+    RadixNode * smaller;
+
+    if (node->type == RadixNode::NODE256) {
+        smaller = new RadixNode48();
+    }
+    else if (node->type == RadixNode::NODE48) {
+        smaller = new RadixNode16();
+    }
+    else {
+        smaller = new RadixNode4();
+    }
+    release(node);
+    node = smaller;
+    for (int i = 0; i < size; ++i) {
+        addChild(node, bytes[i], children[i]);
+    }
+};
+
+/**
+ * Frees node and every inner node below it.
+ */
+void RadixTree::destroy(RadixNode * node) {
+    if (node == NULL || isLeaf(node)) {
+        return;
+    }
+    uint8_t bytes[256];
+    RadixNode * children[256];
+    int size = listChildren(node, bytes, children);
+    for (int i = 0; i < size; ++i) {
+        destroy(children[i]);
+    }
+    release(node);
+};
+
+/**
+ * Frees node alone, as the size it really is.
+ */
+void RadixTree::release(RadixNode * node) {
+    switch (node->type) {
+        case RadixNode::NODE4:
+            delete static_cast<RadixNode4 *>(node);
+            break;
+        case RadixNode::NODE16:
+            delete static_cast<RadixNode16 *>(node);
+            break;
+        case RadixNode::NODE48:
+            delete static_cast<RadixNode48 *>(node);
+            break;
+        default:
+            delete static_cast<RadixNode256 *>(node);
+    }
+};
+
+size_t RadixTree::memoryRecurse(const RadixNode * node) {
+    if (node == NULL || isLeaf(node)) {
+        return 0;
+    }
+    static const size_t SIZES[] = { sizeof(RadixNode4), sizeof(RadixNode16),
+                                    sizeof(RadixNode48), sizeof(RadixNode256) };
+    uint8_t bytes[256];
+    RadixNode * children[256];
+    int size = listChildren(node, bytes, children);
+    size_t used = SIZES[node->type];
+    for (int i = 0; i < size; ++i) {
+        used += memoryRecurse(children[i]);
+    }
+    return used;
+};
@@ -0,0 +1,65 @@
+/**
+ * @brief Function prototypes for an adaptive radix tree of integers.
+ *
+ * Keys are split into their four bytes, most significant first, and each
+ * inner node picks the child for one byte, so a lookup takes at most four
+ * steps however many keys are stored, and never compares two whole keys
+ * until it reaches a leaf. Inner nodes grow from 4 to 16, 48 and 256 slots
+ * only as they need to, and the 16 slot node is searched with a single SSE2
+ * compare where that is available.
+ *
+ * A key gets inner nodes only for the bytes it shares with another key: a
+ * lone key hangs off the first node where it differs, as a leaf packed into
+ * the child pointer, so leaves cost no memory of their own.
+ *
+ * Only integer keys are stored. ItemType keys of other kinds are never
+ * found and never inserted.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef RADIXTREE_H
+#define RADIXTREE_H
+
+#include "RadixNode.h"
+#include "ItemType.h"
+#include <iostream>
+#include <vector>
+
+using std::ostream;
+
+class RadixTree {
+    public:
+        RadixTree();
+        ~RadixTree();
+        int length() const;
+        void insertItem(ItemType & item);
+        void deleteItem(ItemType & item);
+        void retrieve(ItemType & item, bool & found) const;
+        void range(ItemType & low, ItemType & high, std::vector<ItemType> & items) const;
+        void clear();
+        void inOrder() const;
+        size_t memoryUsed() const;
+        friend ostream & operator<<(ostream & stream, const RadixTree & tree);
+
+    private:
+        int count;
+        RadixNode * root;
+        RadixTree(const RadixTree &);            // nodes are owned, no copies
+        RadixTree & operator=(const RadixTree &);
+        bool insert(RadixNode *& node, uint32_t key, int depth);
+        bool remove(RadixNode *& node, uint32_t key, int depth);
+        void visit(const RadixNode * node, uint32_t prefix, int depth, uint32_t low, uint32_t high,
+                   std::vector<int> & keys) const;
+        static int listChildren(const RadixNode * node, uint8_t * bytes, RadixNode ** children);
+        static RadixNode ** findChild(RadixNode * node, uint8_t byte);
+        static void addChild(RadixNode *& node, uint8_t byte, RadixNode * child);
+        static void removeChild(RadixNode *& node, uint8_t byte);
+        static void grow(RadixNode *& node);
+        static void shrink(RadixNode *& node);
+        static void destroy(RadixNode * node);
+        static void release(RadixNode * node);
+        static size_t memoryRecurse(const RadixNode * node);
+};
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @brief Prototype for a socket server sharing one tree between processes.
+ *
+ * The server listens on a Unix domain socket or a loopback TCP port and
+ * serves every connection from a single epoll loop, so the tree is only
+ * ever touched by one thread and needs no locking.
+ *
+ * Requests use the journal's record layout: an operation byte followed by a
+ * key, written as its kind byte, its 4 byte encoded size and the encoded
+ * bytes. A range request carries two keys, the lowest and the highest.
+ * Insert, delete and retrieve are answered with one status byte, 1 if the
+ * item was inserted, deleted or found. A range is answered with a 4 byte
+ * count followed by that many keys in ascending order, each written as
+ * kind, size and bytes.
+ *
+ * Clients may pipeline as deep as they like. Every complete request read
+ * from a connection is answered in order, and the replies to a whole batch
+ * go out in a single write once any journal group commit is done, never
+ * one write per request.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ItemType.h"
+
+class BinaryTree;
+class Journal;
+
+class Server {
+    public:
+        enum Operation {
+            INSERT = 'i',
+            DELETE = 'd',
+            RETRIEVE = 'r',
+            RANGE = 'g'
+        };
+
+        explicit Server(BinaryTree & tree, Journal * journal = NULL);
+        ~Server();
+        bool listenUnix(const std::string & path);
+        bool listenTcp(int port);
+        void run();
+
+    private:
+        struct Connection {
+            int fd;
+            std::string input;     // received, not yet a complete request
+            std::string output;    // replies not yet accepted by the socket
+            unsigned int watching; // epoll events currently asked for
+            bool closing;          // peer is done sending
+        };
+
+        BinaryTree & tree;
+        Journal * journal;
+        int events;                // the epoll instance
+        int listener;
+        std::string socketPath;    // removed again on shutdown
+        std::unordered_map<int, Connection *> connections;
+        std::vector<ItemType> found;
+        Server(const Server &);
+        Server & operator=(const Server &);
+        bool startListening(int fd);
+        void acceptAll();
+        bool receive(Connection * connection);
+        bool handle(Connection * connection);
+        bool flush(Connection * connection);
+        void watch(Connection * connection, unsigned int wanted);
+        void drop(Connection * connection);
+};
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ * @brief Function implementations for a key range sharded binary tree.
+ *
+ * Shards are ordered by key range, so the in order output of the whole
+ * container is simply every shard's in order output one after the other.
+ *
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include <algorithm>
+#include "ShardedBinaryTree.h"
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+static const size_t SAMPLE_SIZE = 1024;  // keys kept for estimating quantiles
+static const int MINIMUM_SHARD = 1024;   // don't bother rebalancing tiny shards
+static const int SKEW = 2;               // rebalance past twice the fair share
+static const double SHARD_HEIGHT = 2.0;  // rebuild a shard's tree past 2 * log2(n)
+
+ShardedBinaryTree::ShardedBinaryTree(int shards) {
+    for (int i = 0; i < (shards > 0 ? shards : 1); ++i) {
+        this->shards.push_back(new Shard());
+        this->shards[i]->tree.setAutoRebalance(SHARD_HEIGHT);
+    }
+    this->count = 0;    // no bounds yet, everything routes to the first shard
+    this->sampled = 0;  // until the first rebalance
+    this->changes = 0;
+};
+
+ShardedBinaryTree::~ShardedBinaryTree() {
+    for (size_t i = 0; i < this->shards.size(); ++i) {
+        delete this->shards[i];
+    }
+};
+
+int ShardedBinaryTree::length() const {
+    return this->count;
+};
+
+void ShardedBinaryTree::insertItem(ItemType & item) {
+    bool skewed;
+    addSample(item);
+    {
+        std::shared_lock<std::shared_timed_mutex> routed(this->routing);
+        Shard * shard = this->shards[route(item)];
+        std::lock_guard<std::mutex> locked(shard->lock);
+        int before = shard->tree.length();
+        shard->tree.insertItem(item);
+        int size = shard->tree.length();
+        this->count += size - before;  // duplicates don't change the count
+        this->changes++;
+        skewed = size > MINIMUM_SHARD &&
+                 size > SKEW * (this->count / (int) this->shards.size());
+    }
+    if (skewed) {                      // routing lock must be released first
+        std::unique_lock<std::shared_timed_mutex> routed(this->routing);
+        if (isSkewed() && this->changes > this->count / 2) {
+            redistribute();            // unless another thread got here first
+        }
+    }
+};
+
+void ShardedBinaryTree::deleteItem(ItemType & item) {
+    std::shared_lock<std::shared_timed_mutex> routed(this->routing);
+    Shard * shard = this->shards[route(item)];
+    std::lock_guard<std::mutex> locked(shard->lock);
+    int before = shard->tree.length();
+    shard->tree.deleteItem(item);
+    this->count += shard->tree.length() - before;
+};
+
+void ShardedBinaryTree::retrieve(ItemType & item, bool & found) const {
+    std::shared_lock<std::shared_timed_mutex> routed(this->routing);
+    Shard * shard = this->shards[route(item)];
+    std::lock_guard<std::mutex> locked(shard->lock);
+    shard->tree.retrieve(item, found);
+};
+
+void ShardedBinaryTree::clear() {
+    std::unique_lock<std::shared_timed_mutex> routed(this->routing);
+    for (size_t i = 0; i < this->shards.size(); ++i) {
+        this->shards[i]->tree.clear();
+    }
+    this->count = 0;   // the boundaries are kept, they are still a fair guess
+};
+
+void ShardedBinaryTree::inOrder() const {
+    cout << *this << endl;
+};
+
+/**
+ * Recomputes the shard boundaries from the sampled key quantiles and moves
+ * every key into its new shard. This also happens automatically once a
+ * shard outgrows its fair share, but no more than once per count / 2
+ * inserts, so a skew the sample can't fix doesn't rebuild on every insert.
+ */
+void ShardedBinaryTree::rebalanceShards() {
+    std::unique_lock<std::shared_timed_mutex> routed(this->routing);
+    redistribute();
+};
+
+/**
+ * Moves every key into the shard the new boundaries assign it to, only
+ * called with the routing lock held exclusively.
+ */
+void ShardedBinaryTree::redistribute() {
+    vector<ItemType> keys;                 // shards are ordered, so this is sorted
+    for (size_t i = 0; i < this->shards.size(); ++i) {
+        this->shards[i]->tree.collect(keys);
+    }
+    vector<ItemType> quantiles;
+    {
+        std::lock_guard<std::mutex> locked(this->sampleLock);
+        quantiles = this->sample;
+    }
+    std::sort(quantiles.begin(), quantiles.end(), [](const ItemType & a, const ItemType & b) {
+        return a.compareTo(b) == ItemType::LESSER;
+    });
+
+    this->bounds.clear();                  // one boundary between each pair of shards
+    for (size_t i = 1; i < this->shards.size() && !quantiles.empty(); ++i) {
+        this->bounds.push_back(quantiles[i * quantiles.size() / this->shards.size()]);
+    }
+
+    size_t start = 0;                      // hand every shard its slice of keys
+    for (size_t i = 0; i < this->shards.size(); ++i) {
+        size_t end = start;
+        while (end < keys.size() && (i >= this->bounds.size() ||
+               this->bounds[i].compareTo(keys[end]) == ItemType::GREATER)) {
+            end++;
+        }
+        vector<ItemType> slice(keys.begin() + start, keys.begin() + end);
+        this->shards[i]->tree.build(slice);
+        start = end;
+    }
+    this->changes = 0;
+};
+
+/**
+ * Index of the shard owning the item: the number of boundaries that are
+ * less than or equal to it.
+ */
+int ShardedBinaryTree::route(ItemType & item) const {
+    int low = 0;
+    int high = (int) this->bounds.size();
+
+    while (low < high) {                   // binary search the boundaries
+        int middle = low + (high - low) / 2;
+        if (this->bounds[middle].compareTo(item) == ItemType::GREATER) {
+            high = middle;
+        }
+        else {
+            low = middle + 1;
+        }
+    }
+    return low;
+};
+
+/**
+ * Reservoir sampling, where the n-th key replaces a random slot with
+ * probability SAMPLE_SIZE / n. The sample lock is only taken for keys that
+ * make it into the reservoir, which gets rarer the more keys are seen.
+ */
+void ShardedBinaryTree::addSample(ItemType & item) {
+    unsigned long seen = ++this->sampled;
+    unsigned long long mixed = seen * 0x9E3779B97F4A7C15ULL; // splitmix64 finalizer
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+    mixed ^= mixed >> 31;
+    size_t slot = seen <= SAMPLE_SIZE ? seen - 1 : (size_t) (mixed % seen);
+
+    if (slot < SAMPLE_SIZE) {
+        std::lock_guard<std::mutex> locked(this->sampleLock);
+        if (this->sample.size() < SAMPLE_SIZE) {
+            this->sample.push_back(item);
+        }
+        else {
+            this->sample[slot] = item;
+        }
+    }
+};
+
+/**
+ * Whether any shard holds more than its fair share, only called with the
+ * routing lock held exclusively.
+ */
+bool ShardedBinaryTree::isSkewed() const {
+    int fair = this->count / (int) this->shards.size();
+
+    for (size_t i = 0; i < this->shards.size(); ++i) {
+        int size = this->shards[i]->tree.length();
+        if (size > MINIMUM_SHARD && size > SKEW * fair) {
+            return true;
+        }
+    }
+    return false;
+};
+
+ostream & operator<<(ostream & stream, const ShardedBinaryTree & tree) {
+    std::shared_lock<std::shared_timed_mutex> routed(tree.routing);
+    for (size_t i = 0; i < tree.shards.size(); ++i) {
+        std::lock_guard<std::mutex> locked(tree.shards[i]->lock);
+        stream << tree.shards[i]->tree;    // shards are already in key order
+    }
+    return stream;
+};
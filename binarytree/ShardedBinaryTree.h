@@ -0,0 +1,60 @@
+/**
+ * @brief Function prototypes for a key range sharded binary tree.
+ *
+ * The key space is split into a number of shards, each a BinaryTree behind
+ * its own lock, so writers to different key ranges never wait on each other.
+ * Shard boundaries are quantiles of a reservoir sample of inserted keys, and
+ * are recomputed once one shard grows well past its fair share.
+ *
+ * Every operation holds the routing lock shared, and rebalancing the shards
+ * takes it exclusively, so the boundaries never move under an operation.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef SHARDEDBINARYTREE_H
+#define SHARDEDBINARYTREE_H
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include "BinaryTree.h"
+
+using std::ostream;
+
+class ShardedBinaryTree {
+    public:
+        explicit ShardedBinaryTree(int shards = 8);
+        ~ShardedBinaryTree();
+        int length() const;
+        void insertItem(ItemType & item);
+        void deleteItem(ItemType & item);
+        void retrieve(ItemType & item, bool & found) const;
+        void clear();
+        void inOrder() const;
+        void rebalanceShards();
+        friend ostream & operator<<(ostream & stream, const ShardedBinaryTree & tree);
+
+    private:
+        struct Shard {
+            BinaryTree tree;
+            std::mutex lock;
+        };
+
+        std::vector<Shard *> shards;
+        std::vector<ItemType> bounds;       // smallest key of every shard after the first
+        mutable std::shared_timed_mutex routing;
+        std::atomic<int> count;
+        std::atomic<int> changes;           // inserts since the last rebalance
+        std::vector<ItemType> sample;       // reservoir of inserted keys
+        std::atomic<unsigned long> sampled;
+        std::mutex sampleLock;
+        int route(ItemType & item) const;
+        void addSample(ItemType & item);
+        bool isSkewed() const;
+        void redistribute();
+};
+
+#endif
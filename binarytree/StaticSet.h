@@ -0,0 +1,132 @@
+/**
+ * @brief A read-only sorted set of integer keys built at compile time.
+ *
+ * For key sets that never change there is no need to load and insert them
+ * on every start. StaticSet sorts the keys and drops duplicates while the
+ * program is being compiled, so the finished table sits in read-only data
+ * and startup costs nothing. It answers the same retrieve and length
+ * queries as BinaryTree.
+ *
+ * Lookups are a branchless binary search. The table always has exactly N
+ * slots (the tail is padded with the largest key), so the search makes the
+ * same fixed number of steps for every key and the compiler can unroll it
+ * for each table size.
+ *
+ * Keys come from an array, which can be filled from a text file of keys:
+ *
+ *     $ tr -s ' \t\n' ',' < keys.txt > keys.csv
+ *
+ *     constexpr int KEYS[] = {
+ *     #include "keys.csv"
+ *     };
+ *     constexpr auto FIXED = makeStaticSet(KEYS);
+ *
+ * Being a template, the whole implementation lives in this header.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef STATICSET_H
+#define STATICSET_H
+
+#include <iostream>
+#include "ItemType.h"
+
+using std::ostream;
+
+template <int N>
+class StaticSet {
+    public:
+        constexpr explicit StaticSet(const int (&keys)[N]) : table(), count(0) {
+            for (int i = 0; i < N; ++i) {
+                this->table[i] = keys[i];
+            }
+            sort();
+            for (int i = 0; i < N; ++i) {        // squeeze out duplicates
+                if (this->count == 0 || this->table[i] != this->table[this->count - 1]) {
+                    this->table[this->count++] = this->table[i];
+                }
+            }
+            for (int i = this->count; i < N; ++i) { // pad with the largest key
+                this->table[i] = this->table[this->count - 1];
+            }
+        };
+
+        constexpr int length() const {
+            return this->count;
+        };
+
+        constexpr bool contains(int key) const {
+            int index = lowerBound(key);
+            return index < N && this->table[index] == key;
+        };
+
+        void retrieve(ItemType & item, bool & found) const {
+            found = item.getKind() == ItemType::INTEGER && contains(item.getValue());
+        };
+
+        friend ostream & operator<<(ostream & stream, const StaticSet & set) {
+            for (int i = 0; i < set.count; ++i) {
+                stream << set.table[i] << " ";
+            }
+            return stream;
+        };
+
+    private:
+        int table[N];
+        int count;
+
+        /**
+         * Index of the first key not less than key, or N if there is none.
+         * Every step halves the candidates with a conditional move rather
+         * than a branch, and the number of steps depends only on N.
+         */
+        constexpr int lowerBound(int key) const {
+            int base = 0;
+            for (int size = N; size > 1; size -= size / 2) {
+                base = this->table[base + size / 2] < key ? base + size / 2 : base;
+            }
+            return base + (this->table[base] < key);
+        };
+
+        /**
+         * Heapsort, to keep the number of compile time steps at N log N.
+         */
+        constexpr void sort() {
+            for (int i = N / 2 - 1; i >= 0; --i) {
+                siftDown(i, N);
+            }
+            for (int end = N - 1; end > 0; --end) {
+                int largest = this->table[0];
+                this->table[0] = this->table[end];
+                this->table[end] = largest;
+                siftDown(0, end);
+            }
+        };
+
+        constexpr void siftDown(int node, int size) {
+            while (2 * node + 1 < size) {
+                int child = 2 * node + 1;
+                if (child + 1 < size && this->table[child + 1] > this->table[child]) {
+                    child++;
+                }
+                if (this->table[node] >= this->table[child]) {
+                    return;
+                }
+                int temp = this->table[node];
+                this->table[node] = this->table[child];
+                this->table[child] = temp;
+                node = child;
+            }
+        };
+};
+
+/**
+ * Builds a StaticSet from an array of keys, deducing its size.
+ */
+template <int N>
+constexpr StaticSet<N> makeStaticSet(const int (&keys)[N]) {
+    return StaticSet<N>(keys);
+}
+
+#endif
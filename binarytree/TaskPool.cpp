@@ -0,0 +1,142 @@
+/**
+ * @brief Implementation of the work stealing thread pool.
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include "TaskPool.h"
+
+using std::function;
+
+static thread_local TaskPool * currentPool = NULL; // pool this thread works for
+static thread_local int currentWorker = -1;        // and its index, -1 outside
+
+TaskPool::TaskPool(unsigned int threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    this->stopping = false;
+    this->queued = 0;
+    this->next = 0;
+
+    for (unsigned int i = 0; i < (threads > 0 ? threads : 1); ++i) {
+        this->workers.push_back(new Worker());
+    }
+    for (unsigned int i = 0; i < this->workers.size(); ++i) {
+        this->threads.push_back(std::thread(&TaskPool::work, this, i));
+    }
+};
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> locked(this->sleepLock);
+        this->stopping = true;
+    }
+    this->sleeping.notify_all();
+
+    for (size_t i = 0; i < this->threads.size(); ++i) {
+        this->threads[i].join();
+    }
+    for (size_t i = 0; i < this->workers.size(); ++i) {
+        delete this->workers[i];
+    }
+};
+
+unsigned int TaskPool::size() const {
+    return (unsigned int) this->workers.size();
+};
+
+/**
+ * Queues a task on the calling worker's own deque, or spreads tasks from
+ * outside the pool across the workers.
+ */
+void TaskPool::push(const function<void()> & task) {
+    unsigned int index = currentPool == this ? (unsigned int) currentWorker
+                                              : this->next++ % this->workers.size();
+    {
+        std::lock_guard<std::mutex> locked(this->workers[index]->lock);
+        this->workers[index]->tasks.push_back(task);
+    }
+    {
+        std::lock_guard<std::mutex> locked(this->sleepLock);
+        this->queued++;
+    }
+    this->sleeping.notify_one();
+};
+
+/**
+ * Runs one queued task: the newest of this worker's own, failing that the
+ * oldest of another's. Returns false if there was nothing to run.
+ */
+bool TaskPool::runOne() {
+    unsigned int self = currentPool == this ? (unsigned int) currentWorker : 0;
+    function<void()> task;
+
+    for (unsigned int i = 0; i < this->workers.size() && !task; ++i) {
+        Worker * worker = this->workers[(self + i) % this->workers.size()];
+        std::lock_guard<std::mutex> locked(worker->lock);
+
+        if (worker->tasks.empty()) {
+            continue;
+        }
+        if (i == 0 && currentPool == this) {  // own deque, newest first
+            task = worker->tasks.back();
+            worker->tasks.pop_back();
+        }
+        else {                                // steal, oldest first
+            task = worker->tasks.front();
+            worker->tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    this->queued--;
+    task();
+    return true;
+};
+
+void TaskPool::work(unsigned int index) {
+    currentPool = this;
+    currentWorker = (int) index;
+
+    while (true) {
+        if (runOne()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> locked(this->sleepLock);
+        this->sleeping.wait(locked, [this] { return this->stopping || this->queued > 0; });
+        if (this->stopping) {
+            return;
+        }
+    }
+};
+
+TaskPool::Group::Group(TaskPool & pool) : pool(pool) {
+    this->pending = 0;
+};
+
+TaskPool::Group::~Group() {
+    wait();                                   // never leave tasks behind
+};
+
+void TaskPool::Group::spawn(const function<void()> & task) {
+    this->pending++;
+    std::atomic<int> * pending = &this->pending;
+    this->pool.push([task, pending] {
+        task();
+        (*pending)--;
+    });
+};
+
+/**
+ * Waits for every task spawned in this group, running queued tasks in the
+ * meantime rather than blocking a thread the pool may need.
+ */
+void TaskPool::Group::wait() {
+    while (this->pending > 0) {
+        if (!this->pool.runOne()) {
+            std::this_thread::yield();
+        }
+    }
+};
@@ -0,0 +1,63 @@
+/**
+ * @brief Prototype for a work stealing thread pool.
+ *
+ * Every worker keeps its own deque of tasks. A worker pushes and pops the
+ * back of its own deque, so recently forked (and still cache warm) work is
+ * run first, and an idle worker steals from the front of another's deque,
+ * taking the oldest and usually largest piece of work.
+ *
+ * Work is forked and joined through a Group. Waiting on a group runs other
+ * queued tasks instead of blocking, so recursive fork/join never deadlocks
+ * the pool however deep it goes.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskPool {
+    public:
+        class Group {
+            public:
+                explicit Group(TaskPool & pool);
+                ~Group();
+                void spawn(const std::function<void()> & task);
+                void wait();
+
+            private:
+                TaskPool & pool;
+                std::atomic<int> pending;
+        };
+
+        explicit TaskPool(unsigned int threads = 0);
+        ~TaskPool();
+        unsigned int size() const;
+
+    private:
+        struct Worker {
+            std::deque< std::function<void()> > tasks;
+            std::mutex lock;
+        };
+
+        std::vector<Worker *> workers;
+        std::vector<std::thread> threads;
+        std::atomic<bool> stopping;
+        std::atomic<int> queued;
+        std::atomic<unsigned int> next;     // round robin for tasks from outside
+        std::mutex sleepLock;
+        std::condition_variable sleeping;
+        void push(const std::function<void()> & task);
+        bool runOne();
+        void work(unsigned int index);
+};
+
+#endif
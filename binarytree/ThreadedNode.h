@@ -0,0 +1,22 @@
+/** 
+ * @brief Defines the structure of a node in the threaded binary tree.
+ * @author Jennifer Teissler
+ */
+
+#ifndef THREADEDNODE_H
+#define THREADEDNODE_H
+
+#include <cstdlib>
+#include "ItemType.h"
+
+struct ThreadedNode {
+    ItemType item;
+    ThreadedNode * left;   // left child, or the in order predecessor if leftThread
+    ThreadedNode * right;  // right child, or the in order successor if rightThread
+    bool leftThread;
+    bool rightThread;
+    explicit ThreadedNode(ItemType & item) : item(item), left(NULL), right(NULL),
+                                             leftThread(true), rightThread(true) {};
+};
+
+#endif
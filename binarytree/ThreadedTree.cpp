@@ -0,0 +1,336 @@
+/**
+ * @brief Function implementations for a threaded binary tree.
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include "ThreadedTree.h"
+
+using std::cout;
+using std::endl;
+using std::ostream;
+
+ThreadedTree::ThreadedTree() {
+    this->count = 0;
+    this->root = NULL;
+};
+
+ThreadedTree::~ThreadedTree() {
+    clear();
+};
+
+int ThreadedTree::length() const {
+    return this->count;
+};
+
+void ThreadedTree::insertItem(ItemType & item) {
+    ThreadedNode * parent = NULL;
+    ThreadedNode * node = this->root;
+    ItemType::Comparison comparison = ItemType::EQUAL;
+
+    while (node != NULL) {                 // descend until a thread is reached
+        comparison = item.compareTo(node->item);
+        if (comparison == ItemType::EQUAL) {
+            return;                        // duplicate, nothing inserted
+        }
+        parent = node;
+        if (comparison == ItemType::LESSER) {
+            node = node->leftThread ? NULL : node->left;
+        }
+        else {
+            node = node->rightThread ? NULL : node->right;
+        }
+    }
+
+    node = new ThreadedNode(item);
+    if (parent == NULL) {                  // first node, both threads stay NULL
+        this->root = node;
+    }
+    else if (comparison == ItemType::LESSER) {
+        node->left = parent->left;         // inherit the parent's predecessor
+        node->right = parent;              // and the parent becomes the successor
+        parent->left = node;
+        parent->leftThread = false;
+    }
+    else {
+        node->right = parent->right;       // inherit the parent's successor
+        node->left = parent;               // and the parent becomes the predecessor
+        parent->right = node;
+        parent->rightThread = false;
+    }
+    this->count++;
+};
+
+/**
+ * A node with two children is replaced by relinking its in order successor
+ * rather than by copying the successor's item over, so no node other than
+ * the deleted one ever changes, and cursors on other nodes stay valid.
+ */
+void ThreadedTree::deleteItem(ItemType & item) {
+    ThreadedNode * parent = NULL;
+    ThreadedNode * node = this->root;
+
+    while (node != NULL) {
+        ItemType::Comparison comparison = item.compareTo(node->item);
+        if (comparison == ItemType::EQUAL) {
+            break;
+        }
+        parent = node;
+        if (comparison == ItemType::LESSER) {
+            node = node->leftThread ? NULL : node->left;
+        }
+        else {
+            node = node->rightThread ? NULL : node->right;
+        }
+    }
+    if (node == NULL) {
+        return;                            // not in the tree
+    }
+
+    if (!node->leftThread && !node->rightThread) { // two children
+        ThreadedNode * replacementParent = node;
+        ThreadedNode * replacement = node->right;
+        while (!replacement->leftThread) {
+            replacementParent = replacement;
+            replacement = replacement->left;
+        }
+        unlink(replacement, replacementParent); // threads to it now lead to node
+
+        replacement->left = node->left;    // take over node's place
+        replacement->leftThread = node->leftThread;
+        replacement->right = node->right;
+        replacement->rightThread = node->rightThread;
+        predecessor(replacement)->right = replacement; // and the threads to node
+        if (!replacement->rightThread) {
+            successor(replacement)->left = replacement;
+        }
+
+        if (parent == NULL) {
+            this->root = replacement;
+        }
+        else if (!parent->leftThread && parent->left == node) {
+            parent->left = replacement;
+        }
+        else {
+            parent->right = replacement;
+        }
+    }
+    else {
+        unlink(node, parent);
+    }
+    this->count--;
+    delete node;
+};
+
+/**
+ * Removes a node with at most one child from the tree, repointing the
+ * threads that led to it at its own predecessor and successor.
+ */
+void ThreadedTree::unlink(ThreadedNode * node, ThreadedNode * parent) {
+    if (node->leftThread && node->rightThread) { // leaf, parent's link becomes a thread
+        if (parent == NULL) {
+            this->root = NULL;
+        }
+        else if (!parent->leftThread && parent->left == node) {
+            parent->left = node->left;
+            parent->leftThread = true;
+        }
+        else {
+            parent->right = node->right;
+            parent->rightThread = true;
+        }
+        return;
+    }
+
+    ThreadedNode * child;
+    if (node->leftThread) {                // only a right child, whose leftmost
+        child = node->right;               // node's thread leads back to node
+        successor(node)->left = node->left;
+    }
+    else {                                 // only a left child, whose rightmost
+        child = node->left;                // node's thread leads back to node
+        predecessor(node)->right = node->right;
+    }
+
+    if (parent == NULL) {
+        this->root = child;
+    }
+    else if (!parent->leftThread && parent->left == node) {
+        parent->left = child;
+    }
+    else {
+        parent->right = child;
+    }
+};
+
+void ThreadedTree::retrieve(ItemType & item, bool & found) const {
+    ThreadedNode * node = bound(item, true);
+    found = node != NULL && item.compareTo(node->item) == ItemType::EQUAL;
+};
+
+/**
+ * Frees every node in order without a stack: a node's successor is always
+ * reached through nodes that come after it, so it is safe to delete each
+ * node once its successor is known.
+ */
+void ThreadedTree::clear() {
+    ThreadedNode * node = this->root;
+    while (node != NULL && !node->leftThread) {
+        node = node->left;
+    }
+    while (node != NULL) {
+        ThreadedNode * next = successor(node);
+        delete node;
+        node = next;
+    }
+    this->root = NULL;
+    this->count = 0;
+};
+
+void ThreadedTree::inOrder() const {
+    cout << *this << endl;
+};
+
+/**
+ * Finds the smallest item greater than item, which need not be in the tree.
+ * Returns false if there is none.
+ */
+bool ThreadedTree::next(ItemType & item, ItemType & following) const {
+    ThreadedNode * node = bound(item, false);
+    if (node != NULL) {
+        following = node->item;
+    }
+    return node != NULL;
+};
+
+/**
+ * Finds the largest item less than item, which need not be in the tree.
+ * Returns false if there is none.
+ */
+bool ThreadedTree::previous(ItemType & item, ItemType & preceding) const {
+    ThreadedNode * node = this->root;
+    ThreadedNode * candidate = NULL;       // largest node below item so far
+
+    while (node != NULL) {
+        ItemType::Comparison comparison = item.compareTo(node->item);
+        if (comparison == ItemType::EQUAL) {
+            candidate = predecessor(node); // one hop along the threads
+            break;
+        }
+        if (comparison == ItemType::GREATER) {
+            candidate = node;
+            node = node->rightThread ? NULL : node->right;
+        }
+        else {
+            node = node->leftThread ? NULL : node->left;
+        }
+    }
+    if (candidate != NULL) {
+        preceding = candidate->item;
+    }
+    return candidate != NULL;
+};
+
+ThreadedTree::Cursor ThreadedTree::first() const {
+    ThreadedNode * node = this->root;
+    while (node != NULL && !node->leftThread) {
+        node = node->left;
+    }
+    return Cursor(node);
+};
+
+ThreadedTree::Cursor ThreadedTree::last() const {
+    ThreadedNode * node = this->root;
+    while (node != NULL && !node->rightThread) {
+        node = node->right;
+    }
+    return Cursor(node);
+};
+
+/**
+ * Cursor on the first item not less than item.
+ */
+ThreadedTree::Cursor ThreadedTree::seek(ItemType & item) const {
+    return Cursor(bound(item, true));
+};
+
+/**
+ * Cursor on the first item greater than item, where a scan that last saw
+ * item carries on from.
+ */
+ThreadedTree::Cursor ThreadedTree::seekAfter(ItemType & item) const {
+    return Cursor(bound(item, false));
+};
+
+/**
+ * The first node whose item is greater than (or, if inclusive, equal to)
+ * item, or NULL if there is none.
+ */
+ThreadedNode * ThreadedTree::bound(ItemType & item, bool inclusive) const {
+    ThreadedNode * node = this->root;
+    ThreadedNode * candidate = NULL;       // smallest node above item so far
+
+    while (node != NULL) {
+        ItemType::Comparison comparison = item.compareTo(node->item);
+        if (comparison == ItemType::EQUAL) {
+            return inclusive ? node : successor(node); // one hop along the threads
+        }
+        if (comparison == ItemType::LESSER) {
+            candidate = node;
+            node = node->leftThread ? NULL : node->left;
+        }
+        else {
+            node = node->rightThread ? NULL : node->right;
+        }
+    }
+    return candidate;
+};
+
+/**
+ * The next node in order: along the right thread, or else the leftmost
+ * node of the right subtree. NULL after the last node.
+ */
+ThreadedNode * ThreadedTree::successor(const ThreadedNode * node) {
+    if (node->rightThread) {
+        return node->right;
+    }
+    ThreadedNode * next = node->right;
+    while (!next->leftThread) {
+        next = next->left;
+    }
+    return next;
+};
+
+ThreadedNode * ThreadedTree::predecessor(const ThreadedNode * node) {
+    if (node->leftThread) {
+        return node->left;
+    }
+    ThreadedNode * previous = node->left;
+    while (!previous->rightThread) {
+        previous = previous->right;
+    }
+    return previous;
+};
+
+ostream & operator<<(ostream & stream, const ThreadedTree & tree) {
+    for (ThreadedTree::Cursor cursor = tree.first(); cursor.valid(); cursor.next()) {
+        stream << cursor.item() << " ";
+    }
+    return stream;
+};
+
+bool ThreadedTree::Cursor::valid() const {
+    return this->node != NULL;
+};
+
+const ItemType & ThreadedTree::Cursor::item() const {
+    return this->node->item;
+};
+
+void ThreadedTree::Cursor::next() {
+    this->node = ThreadedTree::successor(this->node);
+};
+
+void ThreadedTree::Cursor::previous() {
+    this->node = ThreadedTree::predecessor(this->node);
+};
@@ -0,0 +1,67 @@
+/**
+ * @brief Function prototypes for a threaded binary tree.
+ *
+ * A plain binary tree leaves half of its child pointers empty. Here every
+ * empty left pointer instead points at the node's in order predecessor and
+ * every empty right pointer at its successor, tagged as threads so they are
+ * not mistaken for children. Stepping to the next or previous item then
+ * never needs a stack or a descent from the root: it is one thread hop, or
+ * a walk down one subtree, O(1) amortized over a scan.
+ *
+ * Cursors rely on this to scan in either direction in constant space. A
+ * cursor stays valid until the node it is on is deleted.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef THREADEDTREE_H
+#define THREADEDTREE_H
+
+#include "ThreadedNode.h"
+#include <iostream>
+
+using std::ostream;
+
+class ThreadedTree {
+    public:
+        class Cursor {
+            public:
+                bool valid() const;
+                const ItemType & item() const;
+                void next();
+                void previous();
+
+            private:
+                friend class ThreadedTree;
+                const ThreadedNode * node;     // NULL once past either end
+                explicit Cursor(const ThreadedNode * node) : node(node) {};
+        };
+
+        ThreadedTree();
+        ~ThreadedTree();
+        int length() const;
+        void insertItem(ItemType & item);
+        void deleteItem(ItemType & item);
+        void retrieve(ItemType & item, bool & found) const;
+        void clear();
+        void inOrder() const;
+        bool next(ItemType & item, ItemType & following) const;
+        bool previous(ItemType & item, ItemType & preceding) const;
+        Cursor first() const;
+        Cursor last() const;
+        Cursor seek(ItemType & item) const;
+        Cursor seekAfter(ItemType & item) const;
+        friend ostream & operator<<(ostream & stream, const ThreadedTree & tree);
+
+    private:
+        int count;
+        ThreadedNode * root;
+        ThreadedTree(const ThreadedTree &);            // nodes are owned, no copies
+        ThreadedTree & operator=(const ThreadedTree &);
+        static ThreadedNode * successor(const ThreadedNode * node);
+        static ThreadedNode * predecessor(const ThreadedNode * node);
+        ThreadedNode * bound(ItemType & item, bool inclusive) const;
+        void unlink(ThreadedNode * node, ThreadedNode * parent);
+};
+
+#endif
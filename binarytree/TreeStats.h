@@ -0,0 +1,33 @@
+/**
+ * @brief Hot-path counters for the binary tree.
+ *
+ * Counting is compiled in only when TREE_STATS is defined (see the 'stats'
+ * target in the Makefile). Without it the macros expand to nothing and the
+ * tree carries no counters at all, so a regular build pays nothing.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef TREESTATS_H
+#define TREESTATS_H
+
+struct TreeStats {
+    unsigned long comparisons;   // calls to ItemType::compareTo
+    unsigned long visits;        // nodes touched while descending
+    unsigned long allocations;   // nodes created with new
+    unsigned long deallocations; // nodes released with delete
+    int maxDepth;                // deepest descent seen so far
+    TreeStats() : comparisons(0), visits(0), allocations(0), deallocations(0), maxDepth(0) {};
+};
+
+#ifdef TREE_STATS
+#define STATS_COUNT(field)   (++this->statistics.field)
+#define STATS_DESCENT_BEGIN  unsigned long descentStart = this->statistics.visits
+#define STATS_DESCENT_END    this->recordDescent(descentStart)
+#else
+#define STATS_COUNT(field)   ((void) 0)
+#define STATS_DESCENT_BEGIN  ((void) 0)
+#define STATS_DESCENT_END    ((void) 0)
+#endif
+
+#endif
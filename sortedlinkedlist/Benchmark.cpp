@@ -0,0 +1,154 @@
+/**
+ * @brief Insert and search benchmark for the list against the radix tree.
+ *
+ * Inserts the same keys into the sorted list, eagerly and with deferred
+ * sorting, and into the radix tree, then times searches drawn from a
+ * Zipfian distribution, where a few keys take most of the searches, and
+ * from a uniform one for comparison. Keys are distinct IDs spread over all
+ * 32 bits, as in the tree's benchmark. Every list operation walks the list,
+ * so the default run is kept small.
+ *
+ * A key set fixed when the benchmark is compiled is then searched in the
+ * static set built from it at compile time, which has nothing to insert,
+ * and in a list loaded at run time.
+ *
+ * Usage: ./benchmark [keys] [lookups] [skew]
+ *
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include "SortedLinkedList.h"
+#include "RadixTree.h"
+#include "StaticSet.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using std::vector;
+
+/**
+ * The keys fixed at compile time, spread over all 32 bits like the others.
+ */
+template <int N>
+struct FixedKeys {
+    int keys[N];
+    constexpr FixedKeys() : keys() {
+        for (int i = 0; i < N; ++i) {
+            this->keys[i] = (int) ((uint32_t) i * 2654435761u);
+        }
+    };
+};
+
+static constexpr FixedKeys<4096> FIXED_KEYS;
+static constexpr auto FIXED = makeStaticSet(FIXED_KEYS.keys);
+
+/**
+ * Draws lookups keys, picking the key of rank r with probability
+ * proportional to 1 / r^skew. A skew of 0 is uniform.
+ */
+vector<int> zipfian(const vector<int> & keys, int lookups, double skew, std::mt19937 & random) {
+    vector<double> cumulative(keys.size());
+    double total = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        total += 1.0 / pow((double) (i + 1), skew);
+        cumulative[i] = total;
+    }
+    std::uniform_real_distribution<double> uniform(0, total);
+    vector<int> drawn(lookups);
+
+    for (int i = 0; i < lookups; ++i) {
+        size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(random))
+                    - cumulative.begin();
+        drawn[i] = keys[rank < keys.size() ? rank : keys.size() - 1];
+    }
+    return drawn;
+}
+
+/**
+ * Nanoseconds per search over every drawn key.
+ */
+template <typename List>
+double timeLookups(List & list, const vector<int> & drawn) {
+    int found = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < drawn.size(); ++i) {
+        DataType item(drawn[i]);
+        found += list.search(item) != -1;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (found != (int) drawn.size()) {
+        fprintf(stderr, "lost %d keys\n", (int) drawn.size() - found);
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / drawn.size();
+}
+
+/**
+ * Nanoseconds per insert of every key.
+ */
+template <typename List>
+double timeInserts(List & list, const vector<int> & keys) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        DataType item(keys[i]);
+        list.insertItem(item);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / keys.size();
+}
+
+int main(int argc, char * argv[]) {
+    int size = argc > 1 ? atoi(argv[1]) : 1 << 13;
+    int lookups = argc > 2 ? atoi(argv[2]) : 50000;
+    double skew = argc > 3 ? atof(argv[3]) : 0.99;
+    std::mt19937 random(42);
+
+    vector<int> keys(size);
+    for (int i = 0; i < size; ++i) {
+        keys[i] = (int) ((uint32_t) i * 2654435761u);          // odd multiplier, so no repeats
+    }
+    vector<int> ranked(keys);
+    std::shuffle(keys.begin(), keys.end(), random);            // random insertion order,
+    std::shuffle(ranked.begin(), ranked.end(), random);        // and unrelated hot keys
+    vector<int> hot = zipfian(ranked, lookups, skew, random);
+    vector<int> cold = zipfian(ranked, lookups, 0, random);
+
+    printf("%d keys, %d lookups, skew %.2f\n\n", size, lookups, skew);
+    printf("%-18s %12s %12s %12s\n", "mode", "insert ns/op", "zipf ns/op", "unif ns/op");
+
+    for (int deferred = 0; deferred < 2; ++deferred) {
+        SortedLinkedList list;
+        list.setDeferredSort(deferred == 1);
+        double inserted = timeInserts(list, keys);
+        double first = timeLookups(list, hot);                 // includes the deferred sort
+        printf("%-18s %12.1f %12.1f %12.1f\n", deferred ? "list, deferred" : "list",
+               inserted, first, timeLookups(list, cold));
+    }
+
+    RadixTree radix;
+    double inserted = timeInserts(radix, keys);
+    double first = timeLookups(radix, hot);
+    printf("%-18s %12.1f %12.1f %12.1f\n", "radix", inserted, first, timeLookups(radix, cold));
+
+    vector<int> fixed(FIXED_KEYS.keys, FIXED_KEYS.keys + FIXED.length());
+    std::shuffle(fixed.begin(), fixed.end(), random);
+    vector<int> fixedHot = zipfian(fixed, lookups, skew, random);
+    vector<int> fixedCold = zipfian(fixed, lookups, 0, random);
+    SortedLinkedList loaded;
+    inserted = timeInserts(loaded, fixed);
+
+    printf("\n%-18s %12s %12s %12s\n", "4096 fixed keys", "insert ns/op", "zipf ns/op", "unif ns/op");
+    printf("%-18s %12s %12.1f %12.1f\n", "static set", "-",
+           timeLookups(FIXED, fixedHot), timeLookups(FIXED, fixedCold));
+    printf("%-18s %12.1f %12.1f %12.1f\n", "list", inserted,
+           timeLookups(loaded, fixedHot), timeLookups(loaded, fixedCold));
+
+    printf("\n%.1f bytes per key radix, %d per list node\n",
+           (double) radix.memoryUsed() / size, (int) sizeof(ListNode));
+    return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * @brief Implementation of the counting Bloom filter.
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include <cmath>
+#include "BloomFilter.h"
+
+static const uint8_t SATURATED = 255; // counters stick here rather than wrap
+
+/**
+ * Sizes the filter so that holding capacity items gives false positives
+ * at roughly falsePositiveRate: m = -n ln p / (ln 2)^2 counters and
+ * k = (m / n) ln 2 hashes.
+ */
+BloomFilter::BloomFilter(int capacity, double falsePositiveRate) {
+    this->capacity = capacity > 1 ? capacity : 1;
+    this->rate = falsePositiveRate > 0 && falsePositiveRate < 1 ? falsePositiveRate : 0.01;
+    double size = -this->capacity * log(this->rate) / (M_LN2 * M_LN2);
+    int hashes = (int) lround(size / this->capacity * M_LN2);
+
+    this->counters.assign((size_t) ceil(size) + 1, 0);
+    this->hashes = hashes < 1 ? 1 : (hashes > 16 ? 16 : hashes);
+    this->queries = 0;
+    this->rejections = 0;
+    this->falsePositives = 0;
+};
+
+void BloomFilter::add(const DataType & item) {
+    uint64_t index, step;
+    locate(item, index, step);
+
+    for (int i = 0; i < this->hashes; ++i, index += step) {
+        uint8_t & counter = this->counters[index % this->counters.size()];
+        if (counter < SATURATED) {
+            counter++;
+        }
+    }
+};
+
+/**
+ * Undoes an add. Only items that were added may be removed.
+ */
+void BloomFilter::remove(const DataType & item) {
+    uint64_t index, step;
+    locate(item, index, step);
+
+    for (int i = 0; i < this->hashes; ++i, index += step) {
+        uint8_t & counter = this->counters[index % this->counters.size()];
+        if (counter > 0 && counter < SATURATED) { // a saturated count is unknown, keep it
+            counter--;
+        }
+    }
+};
+
+/**
+ * False means the item was certainly never added (or was removed again).
+ */
+bool BloomFilter::mayContain(const DataType & item) const {
+    uint64_t index, step;
+    locate(item, index, step);
+    this->queries++;
+
+    for (int i = 0; i < this->hashes; ++i, index += step) {
+        if (this->counters[index % this->counters.size()] == 0) {
+            this->rejections++;
+            return false;
+        }
+    }
+    return true;
+};
+
+/**
+ * Notes that an item which got past the filter turned out to be missing.
+ */
+void BloomFilter::recordFalsePositive() const {
+    this->falsePositives++;
+};
+
+void BloomFilter::reset() {
+    this->counters.assign(this->counters.size(), 0);
+};
+
+int BloomFilter::getCapacity() const {
+    return this->capacity;
+};
+
+double BloomFilter::getRate() const {
+    return this->rate;
+};
+
+/**
+ * Counters so far, plus the rate expected with items in the filter,
+ * (1 - e^(-k n / m))^k.
+ */
+FilterStats BloomFilter::stats(int items) const {
+    FilterStats stats;
+    stats.queries = this->queries;
+    stats.rejections = this->rejections;
+    stats.falsePositives = this->falsePositives;
+    stats.configuredRate = this->rate;
+    stats.counters = (int) this->counters.size();
+    stats.hashes = this->hashes;
+    stats.estimatedRate = pow(1 - exp(-(double) this->hashes * items / this->counters.size()),
+                              this->hashes);
+    if (this->rejections + this->falsePositives > 0) {
+        stats.observedRate = (double) this->falsePositives / (this->rejections + this->falsePositives);
+    }
+    return stats;
+};
+
+void BloomFilter::resetStats() {
+    this->queries = 0;
+    this->rejections = 0;
+    this->falsePositives = 0;
+};
+
+/**
+ * Hashes the item's kind and encoded bytes (FNV-1a, then two different
+ * finalizers) into the first counter to probe and the stride between probes.
+ */
+void BloomFilter::locate(const DataType & item, uint64_t & first, uint64_t & step) const {
+    const char * bytes = item.getBytes();
+    uint64_t hash = 14695981039346656037ULL ^ (uint64_t) item.getKind();
+
+    for (int i = 0; i < item.getSize(); ++i) {
+        hash = (hash ^ (uint8_t) bytes[i]) * 1099511628211ULL;
+    }
+    first = hash ^ (hash >> 33);
+    first *= 0xff51afd7ed558ccdULL;
+    first ^= first >> 33;
+    step = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    step = (step ^ (step >> 27)) | 1;  // odd, so probes don't repeat early
+};
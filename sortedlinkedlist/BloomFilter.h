@@ -0,0 +1,59 @@
+/**
+ * @brief Prototype for a counting Bloom filter in front of the list.
+ *
+ * The filter answers "certainly not in the list" or "maybe in the list" from
+ * a few probes of a counter array, so most lookups of missing items return
+ * without walking the list at all. Every item bumps a handful of counters
+ * picked by double hashing its encoded bytes. Counters rather than bits let
+ * an item be removed again by undoing its bumps, and let a duplicate be
+ * counted twice. A counter that reaches its maximum stays there for good,
+ * which can cost a false positive but never a false negative.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <stdint.h>
+#include <vector>
+#include "DataType.h"
+
+struct FilterStats {
+    unsigned long queries;        // lookups that asked the filter
+    unsigned long rejections;     // answered by the filter alone, item missing
+    unsigned long falsePositives; // passed the filter, item missing anyway
+    double configuredRate;        // false positive rate the filter was sized for
+    double estimatedRate;         // expected false positive rate at the current load
+    double observedRate;          // share of missing items that got past the filter
+    int counters;
+    int hashes;
+    FilterStats() : queries(0), rejections(0), falsePositives(0), configuredRate(0),
+                    estimatedRate(0), observedRate(0), counters(0), hashes(0) {};
+};
+
+class BloomFilter {
+    public:
+        BloomFilter(int capacity, double falsePositiveRate);
+        void add(const DataType & item);
+        void remove(const DataType & item);
+        bool mayContain(const DataType & item) const;
+        void recordFalsePositive() const;
+        void reset();
+        int getCapacity() const;
+        double getRate() const;
+        FilterStats stats(int items) const;
+        void resetStats();
+
+    private:
+        std::vector<uint8_t> counters;
+        int hashes;
+        int capacity;                 // items the filter was sized for
+        double rate;
+        mutable unsigned long queries;
+        mutable unsigned long rejections;
+        mutable unsigned long falsePositives;
+        void locate(const DataType & item, uint64_t & first, uint64_t & step) const;
+};
+
+#endif
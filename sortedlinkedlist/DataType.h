@@ -5,12 +5,23 @@
  * the implementation and design of the LinkedList from what type of data
  * it is actually storing.
  *
+ * Keys may be integers, strings, or (tenant, id) composites. Every key is
+ * encoded into bytes that sort the same way as the key itself, and the first
+ * PREFIX_SIZE of those bytes are kept inline as one big endian integer, so
+ * that most comparisons are settled by a single integer compare without
+ * leaving the node. Keys of up to INLINE_SIZE bytes are stored inline too,
+ * only longer strings are kept on the heap.
+ *
  * @author Jennifer Teissler
  */
 
 #ifndef DATATYPE_H
 #define DATATYPE_H
 
+#include <stdint.h>
+#include <ostream>
+#include <string>
+
 class DataType {
     public:
         enum Comparison {
@@ -19,12 +30,42 @@ class DataType {
             GREATER
         };
 
-        explicit DataType(int value) : value(value) {};
-        Comparison compareTo (DataType & item) const;
+        enum Kind {        // keys of different kinds order by kind first
+            INTEGER,
+            STRING,
+            COMPOSITE
+        };
+
+        static const int PREFIX_SIZE = 8;
+        static const int INLINE_SIZE = 16;
+
+        explicit DataType(int value);
+        explicit DataType(const std::string & key);
+        DataType(int tenant, int id);
+        DataType(Kind kind, const char * bytes, int size);
+        DataType(const DataType & item);
+        DataType(DataType && item) noexcept;
+        DataType & operator=(const DataType & item);
+        DataType & operator=(DataType && item) noexcept;
+        ~DataType();
+        Comparison compareTo (const DataType & item) const;
         int getValue() const;
+        Kind getKind() const;
+        const char * getBytes() const;
+        int getSize() const;
+        friend std::ostream & operator<<(std::ostream & stream, const DataType & item);
 
     private:
-        int value;
+        uint64_t prefix;   // first PREFIX_SIZE encoded bytes, zero padded
+        uint32_t size;     // length of the encoded key
+        uint8_t kind;
+        union {
+            char local[INLINE_SIZE];
+            char * remote; // only when size > INLINE_SIZE
+        };
+        void assign(Kind kind, const char * bytes, int size);
+        void take(DataType & item);
+        void release();
 };
 
 #endif
@@ -0,0 +1,251 @@
+/**
+ * @brief Implementation of the list journal.
+ *
+ * Both the log and the snapshot start with an 8 byte generation number,
+ * followed by records of one operation byte, the key's kind byte, its 4 byte
+ * encoded size and then the encoded key itself.
+ * Compaction bumps the generation, so a log left over from before a crash
+ * in the middle of compaction is recognised as already folded into the
+ * snapshot and skipped instead of being replayed twice.
+ *
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+#include "Journal.h"
+#include "SortedLinkedList.h"
+
+using std::string;
+
+static const size_t HEADER_SIZE = sizeof(unsigned long);
+static const size_t RECORD_HEADER = 2 + sizeof(uint32_t);
+
+/**
+ * Reads an entire file into memory, returning false if it can't be opened.
+ */
+static bool readFile(const string & name, string & contents) {
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    char chunk[65536];
+    ssize_t size;
+
+    while ((size = read(fd, chunk, sizeof(chunk))) > 0) {
+        contents.append(chunk, size);
+    }
+    close(fd);
+    return true;
+};
+
+/**
+ * Reads the generation number at the start of a journal or snapshot file.
+ */
+static unsigned long readGeneration(const string & contents) {
+    unsigned long generation = 0;
+    if (contents.size() >= HEADER_SIZE) {
+        memcpy(&generation, contents.data(), HEADER_SIZE);
+    }
+    return generation;
+};
+
+Journal::Journal(const string & path, int interval, int batch) {
+    this->path = path;
+    this->pending = 0;
+    this->batch = batch;
+    this->interval = std::chrono::milliseconds(interval);
+    this->lastCommit = std::chrono::steady_clock::now();
+    this->file = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+
+    string contents;
+    readFile(path, contents);
+    if (contents.size() >= HEADER_SIZE) { // existing log, continue its generation
+        this->generation = readGeneration(contents);
+    }
+    else {                                // new log, follow on from the snapshot
+        string snapshot;
+        readFile(path + ".snapshot", snapshot);
+        this->generation = readGeneration(snapshot);
+        if (this->file >= 0) {
+            string header;
+            writeHeader(header);
+            ftruncate(this->file, 0);
+            writeAll(this->file, header);
+        }
+    }
+};
+
+Journal::~Journal() {
+    if (this->file >= 0) {
+        commit();         // flush anything still waiting for a group commit
+        close(this->file);
+    }
+};
+
+bool Journal::isOpen() const {
+    return this->file >= 0;
+};
+
+/**
+ * Buffers a record, committing the group once it is large enough or the
+ * commit interval has passed since the last commit.
+ */
+void Journal::append(Operation operation, const DataType & item) {
+    writeRecord(this->buffer, operation, item);
+    this->pending++;
+
+    if (this->pending >= this->batch ||
+        std::chrono::steady_clock::now() - this->lastCommit >= this->interval) {
+        commit();
+    }
+};
+
+/**
+ * Writes every buffered record and makes them durable with one fdatasync.
+ */
+bool Journal::commit() {
+    this->lastCommit = std::chrono::steady_clock::now();
+    if (this->pending == 0 || this->file < 0) {
+        return this->file >= 0;
+    }
+    bool written = writeAll(this->file, this->buffer) && fdatasync(this->file) == 0;
+    this->buffer.clear();
+    this->pending = 0;
+    return written;
+};
+
+/**
+ * Loads the last snapshot into the list and replays the log on top of it.
+ * This must run before the journal is attached to the list, otherwise the
+ * replayed operations would be logged a second time.
+ */
+void Journal::replay(SortedLinkedList & list) {
+    unsigned long snapshot = replayFile(this->path + ".snapshot", list, false);
+    if (this->generation >= snapshot) { // log is newer than the snapshot
+        replayFile(this->path, list, true);
+    }
+    else if (this->file >= 0) {         // log was folded in before a crash, restart it
+        string header;
+        this->generation = snapshot;
+        writeHeader(header);
+        ftruncate(this->file, 0);
+        writeAll(this->file, header);
+    }
+};
+
+/**
+ * Applies every complete record in a file, returning its generation. A torn
+ * record at the end of the log (from a crash mid-write) is cut off so that
+ * new records are appended after the last complete one.
+ */
+unsigned long Journal::replayFile(const string & name, SortedLinkedList & list, bool isLog) {
+    string contents;
+    if (!readFile(name, contents) || contents.size() < HEADER_SIZE) {
+        return 0;
+    }
+    size_t offset = HEADER_SIZE;
+
+    while (offset + RECORD_HEADER <= contents.size()) {
+        uint32_t size;
+        memcpy(&size, contents.data() + offset + 2, sizeof(uint32_t));
+        if (offset + RECORD_HEADER + size > contents.size()) {
+            break;                      // torn record, its key is incomplete
+        }
+        DataType item((DataType::Kind) contents[offset + 1], contents.data() + offset + RECORD_HEADER, size);
+
+        if (contents[offset] == INSERT) {
+            list.insertItem(item);
+        }
+        else if (contents[offset] == DELETE) {
+            list.deleteItem(item);
+        }
+        else if (contents[offset] == CLEAR) {
+            list.clear();
+        }
+        offset += RECORD_HEADER + size;
+    }
+
+    if (isLog && offset != contents.size() && this->file >= 0) {
+        ftruncate(this->file, offset);  // drop the torn record
+    }
+    return readGeneration(contents);
+};
+
+/**
+ * Writes the list out as a new snapshot and empties the log. The snapshot
+ * is written to a temporary file and renamed into place, so a crash leaves
+ * either the old or the new snapshot, never a partial one.
+ */
+bool Journal::compact(const SortedLinkedList & list) {
+    if (this->file < 0) {
+        return false;
+    }
+    string data;
+    this->generation++;
+    writeHeader(data);
+    list.settle();
+    std::vector<ListNode *> nodes;         // written largest first, so that every
+    for (ListNode * node = list.head; node != NULL; node = node->next) {
+        nodes.push_back(node);             // replayed insert lands at the head
+    }
+    for (size_t i = nodes.size(); i > 0; --i) {
+        writeRecord(data, INSERT, nodes[i - 1]->item);
+    }
+
+    string temp = this->path + ".snapshot.tmp";
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        this->generation--;
+        return false;
+    }
+    bool written = writeAll(fd, data) && fsync(fd) == 0;
+    close(fd);
+    if (!written || rename(temp.c_str(), (this->path + ".snapshot").c_str()) != 0) {
+        this->generation--;
+        return false;
+    }
+
+    size_t slash = this->path.rfind('/');  // make the rename itself durable
+    string directory = slash == string::npos ? "." : this->path.substr(0, slash + 1);
+    int dir = open(directory.c_str(), O_RDONLY);
+    if (dir >= 0) {
+        fsync(dir);
+        close(dir);
+    }
+
+    string header;                         // start an empty log in the new generation
+    writeHeader(header);
+    this->buffer.clear();                  // buffered records are in the snapshot already
+    this->pending = 0;
+    ftruncate(this->file, 0);
+    return writeAll(this->file, header) && fdatasync(this->file) == 0;
+};
+
+bool Journal::writeAll(int fd, const string & data) {
+    size_t offset = 0;
+
+    while (offset < data.size()) {         // write may be partial, keep going
+        ssize_t size = write(fd, data.data() + offset, data.size() - offset);
+        if (size < 0) {
+            return false;
+        }
+        offset += size;
+    }
+    return true;
+};
+
+void Journal::writeHeader(string & data) const {
+    data.append((const char *) &this->generation, HEADER_SIZE);
+};
+
+void Journal::writeRecord(string & data, Operation operation, const DataType & item) const {
+    uint32_t size = (uint32_t) item.getSize();
+    data.push_back((char) operation);
+    data.push_back((char) item.getKind());
+    data.append((const char *) &size, sizeof(uint32_t));
+    data.append(item.getBytes(), size);
+};
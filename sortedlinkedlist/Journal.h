@@ -0,0 +1,56 @@
+/**
+ * @brief Prototype for an append-only journal of list modifications.
+ *
+ * Insert and delete records are buffered in memory and written out with a
+ * single fsync per group commit, either once enough records are pending or
+ * once the commit interval has passed. At most one interval of work can be
+ * lost on a crash, in exchange for not paying an fsync on every insert.
+ *
+ * The journal lives next to a snapshot file ('<path>.snapshot'). Startup
+ * loads the snapshot and replays the log on top of it, and compaction
+ * writes a fresh snapshot of the list and empties the log.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <chrono>
+#include <string>
+#include "ListNode.h"
+
+class SortedLinkedList;
+
+class Journal {
+    public:
+        enum Operation {
+            INSERT = 'i',
+            DELETE = 'd',
+            CLEAR = 'c'
+        };
+
+        explicit Journal(const std::string & path, int interval = 10, int batch = 256);
+        ~Journal();
+        bool isOpen() const;
+        void append(Operation operation, const DataType & item);
+        bool commit();
+        void replay(SortedLinkedList & list);
+        bool compact(const SortedLinkedList & list);
+
+    private:
+        std::string path;
+        int file;
+        unsigned long generation;
+        std::string buffer;
+        int pending;
+        int batch;
+        std::chrono::milliseconds interval;
+        std::chrono::steady_clock::time_point lastCommit;
+        bool writeAll(int fd, const std::string & data);
+        unsigned long replayFile(const std::string & name, SortedLinkedList & list, bool isLog);
+        void writeHeader(std::string & data) const;
+        void writeRecord(std::string & data, Operation operation, const DataType & item) const;
+};
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * @brief Hot-path counters for the sorted linked list.
+ *
+ * Counting is compiled in only when LIST_STATS is defined (see the 'stats'
+ * target in the Makefile). Without it the macros expand to nothing and the
+ * list carries no counters at all, so a regular build pays nothing.
+ *
+ * @author Jennifer Teissler
+ */
+
+#ifndef LISTSTATS_H
+#define LISTSTATS_H
+
+struct ListStats {
+    unsigned long comparisons;   // calls to DataType::compareTo
+    unsigned long visits;        // nodes touched while walking the list
+    unsigned long allocations;   // nodes created with new
+    unsigned long deallocations; // nodes released with delete
+    int maxWalk;                 // longest single walk seen so far
+    ListStats() : comparisons(0), visits(0), allocations(0), deallocations(0), maxWalk(0) {};
+};
+
+#ifdef LIST_STATS
+#define STATS_COUNT(field)   (++this->statistics.field)
+#define STATS_WALK_BEGIN     unsigned long walkStart = this->statistics.visits
+#define STATS_WALK_END       this->recordWalk(walkStart)
+#else
+#define STATS_COUNT(field)   ((void) 0)
+#define STATS_WALK_BEGIN     ((void) 0)
+#define STATS_WALK_END       ((void) 0)
+#endif
+
+#endif
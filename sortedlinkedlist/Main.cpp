@@ -10,21 +10,24 @@
 
 #include <cstdlib>
 #include "SortedLinkedList.h"
+#include "Journal.h"
+#include "Ingest.h"
+#include "Server.h"
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <string>
 #include <iostream>
-#include <fstream>
+#include <vector>
 
 using std::cout;
 using std::cin;
 using std::endl;
 using std::string;
 using std::stoi;
-using std::ifstream;
 
 typedef unsigned short ushort;
 
+void toggleDeferredSort(SortedLinkedList &);
 void pairwiseSwap(SortedLinkedList &);
 void clearList(SortedLinkedList &);
 void deleteValue(SortedLinkedList &);
@@ -33,6 +36,9 @@ void insertValue(SortedLinkedList &);
 void printLength(SortedLinkedList &);
 void printList(SortedLinkedList &);
 void searchValue(SortedLinkedList &);
+void printStats(SortedLinkedList &);
+void setFilter(SortedLinkedList &);
+void compactJournal(SortedLinkedList &, Journal *);
 void information();
 void clearScreen();
 void drawLine();
@@ -41,13 +47,48 @@ int awaitValueInput();
 
 int main(int argc, char * argv[]) {
     SortedLinkedList list;  // initialize the list
+    Journal * journal = NULL;
+    const char * journalPath = NULL;
+    const char * socketPath = NULL; // serve the list instead of reading commands
+    int port = 0;
+    int first = 1;          // index of the first list argument
     clearScreen();          // setup screen
     drawLine();
     information();
     cout << endl;
 
-    if (argc > 2) {         // attempt to read in elements from arguments
-        for (int i = 1; i < argc; ++i) {
+    while (argc - first > 1) { // options come before any list arguments
+        string option = argv[first];
+        if (option == "-j") {
+            journalPath = argv[first + 1];
+        }
+        else if (option == "-u") {
+            socketPath = argv[first + 1];
+        }
+        else if (option == "-t") {
+            port = atoi(argv[first + 1]);
+        }
+        else {
+            break;
+        }
+        first += 2;
+    }
+
+    if (journalPath != NULL) { // replay and keep journaling
+        journal = new Journal(journalPath);
+
+        if (journal->isOpen()) {
+            journal->replay(list);
+            list.attachJournal(journal);
+            cout << "LIST RESTORED FROM JOURNAL '" << journalPath << "'" << endl << list << endl;
+        }
+        else {
+            cout << "UNABLE TO OPEN JOURNAL '" << journalPath << "'" << endl;
+        }
+    }
+
+    if (argc - first > 1) { // attempt to read in elements from arguments
+        for (int i = first; i < argc; ++i) {
             try {           // just skip and silently fail any invalid inputs
                 DataType data(stoi(argv[i]));
                 list.insertItem(data);
@@ -56,26 +97,40 @@ int main(int argc, char * argv[]) {
         }                   // display loaded arguments (if any)
         cout << "LIST LOADED FROM ARGUMENTS" << endl << list << endl;
     }
-    else if (argc == 2) {   // attempt to read in elements from file
-        ifstream file;
-        file.open(argv[1]); // open the file
-
-        if (file) {         // check to make sure file opened
-            int input;
-                            // read all elements from file
-            while (file >> input) {
-                DataType data(input);
-                list.insertItem(data);
+    else if (argc - first == 1) { // attempt to read in elements from file
+        std::vector<DataType> items;
+                            // parse and sort the file on every core
+        if (ingestFile(argv[first], items)) {
+            if (list.length() == 0) {
+                list.build(items); // empty list, build it in one pass
+            }
+            else {          // merge into what the journal restored
+                for (size_t i = 0; i < items.size(); ++i) {
+                    list.insertItem(items[i]);
+                }
             }
         }
-
-        file.close();       // close file and display loaded arguments (if any)
-        cout << "LIST LOADED FROM FILE '" << argv[1] << "'" << endl << list << endl;
+                            // display loaded arguments (if any)
+        cout << "LIST LOADED FROM FILE '" << argv[first] << "'" << endl << list << endl;
     }
-    else {                  // no preloading of arguments
+    else if (journal == NULL) { // no preloading of arguments
         cout << "NO LIST LOADED" << endl;
     }
 
+    if (socketPath != NULL || port > 0) { // serve until interrupted
+        Server server(list, journal);
+        string address = socketPath != NULL ? socketPath : "127.0.0.1:" + std::to_string(port);
+        if (socketPath != NULL ? server.listenUnix(socketPath) : server.listenTcp(port)) {
+            cout << "SERVING LIST ON " << address << ", CTRL-C TO STOP" << endl;
+            server.run();
+        }
+        else {
+            cout << "UNABLE TO LISTEN ON " << address << endl;
+        }
+        delete journal;
+        return EXIT_SUCCESS;
+    }
+
     cout << endl;           // setup screen
     listCommands();
     cout << endl;
@@ -86,16 +141,22 @@ int main(int argc, char * argv[]) {
         cout << "Enter a command letter: ";
                             
         switch(awaitCommandInput()) { 
+            case 'a': toggleDeferredSort(list);
+                      break;
             case 'b': pairwiseSwap(list);
                       break;
             case 'c': clearList(list);
                       break;
             case 'd': deleteValue(list);
                       break;
+            case 'f': setFilter(list);
+                      break;
             case 'h': listCommands();
                       break;
             case 'i': insertValue(list);
                       break;
+            case 'j': compactJournal(list, journal);
+                      break;
             case 'l': printLength(list);
                       break;
             case 'p': printList(list);
@@ -104,12 +165,19 @@ int main(int argc, char * argv[]) {
                       break;
             case 's': searchValue(list);
                       break;
+            case 't': printStats(list);
+                      break;
             case 'z': information();
                       break;
             default:  cout << "Type 'h' for a list of commands." << endl;
         }
+
+        if (journal != NULL) {
+            journal->commit(); // make this command durable before waiting on input
+        }
     }
 
+    delete journal;
     cout << "program exit" << endl;
     drawLine();
     return EXIT_SUCCESS;    // end program
@@ -148,15 +216,19 @@ void deleteValue(SortedLinkedList & list) {
  */
 void listCommands() {
     cout << "\e[1m[COMMANDS]\e[0m" << endl;
+    cout << "[a] Toggle Deferred Sort" << endl;
     cout << "[b] Pairwise Swap" << endl;
     cout << "[c] Clear List" << endl;
     cout << "[d] Delete Value" << endl;
+    cout << "[f] Set Membership Filter" << endl;
     cout << "[h] List Commands" << endl;
     cout << "[i] Insert Value" << endl;
+    cout << "[j] Compact Journal" << endl;
     cout << "[l] Print Length" << endl;
     cout << "[p] Print List" << endl;
     cout << "[q] Quit Program" << endl;
     cout << "[s] Search Value" << endl;
+    cout << "[t] Print Statistics" << endl;
     cout << "[z] Information" << endl << endl;
     cout << "\e[1m[Note]\e[0m Commands may be chained together for complex operations." << endl;
     cout << "       While running chained commands, input sanitization and " << endl;
@@ -174,6 +246,21 @@ void insertValue(SortedLinkedList & list) {
     cout << list << endl;
 }
 
+/**
+ * Folds the journal into a fresh snapshot of the list.
+ */
+void compactJournal(SortedLinkedList & list, Journal * journal) {
+    if (journal == NULL) {
+        cout << "No Journal, start with './main -j [journal]'" << endl;
+    }
+    else if (journal->compact(list)) {
+        cout << "Journal Compacted" << endl;
+    }
+    else {
+        cout << "Journal Compaction Failed" << endl;
+    }
+}
+
 /**
  * Retrieves the length of the list.
  */
@@ -205,6 +292,51 @@ void searchValue(SortedLinkedList & list) {
     }
 }
 
+/**
+ * Prints the hot-path counters collected by the list, then resets them so
+ * that the next snapshot only covers the operations in between.
+ */
+void printStats(SortedLinkedList & list) {
+    ListStats stats = list.stats();
+#ifndef LIST_STATS
+    cout << "Statistics disabled, rebuild with 'make stats'" << endl;
+#endif
+    cout << "Comparisons   = " << stats.comparisons << endl;
+    cout << "Nodes Visited = " << stats.visits << endl;
+    cout << "Longest Walk  = " << stats.maxWalk << endl;
+    cout << "Allocations   = " << stats.allocations << endl;
+    cout << "Deallocations = " << stats.deallocations << endl;
+
+    FilterStats filter = list.filterStats();
+    if (filter.counters > 0) {
+        cout << "Filter Size   = " << filter.counters << " counters, " << filter.hashes << " hashes" << endl;
+        cout << "Filter Probes = " << filter.queries << ", " << filter.rejections << " rejected, "
+             << filter.falsePositives << " false positives" << endl;
+        cout << "FP Rate       = " << filter.observedRate << " observed, "
+             << filter.estimatedRate << " expected, " << filter.configuredRate << " configured" << endl;
+    }
+    list.resetStats();
+}
+
+/**
+ * Switches inserts between sorting in place and appending to a tail that is
+ * sorted on the next read.
+ */
+void toggleDeferredSort(SortedLinkedList & list) {
+    list.setDeferredSort(!list.isDeferredSort());
+    cout << "Deferred Sort " << (list.isDeferredSort() ? "On" : "Off") << endl;
+}
+
+/**
+ * Puts a Bloom filter in front of search, or takes it away again.
+ */
+void setFilter(SortedLinkedList & list) {
+    cout << "Enter the false positive rate as 1 in N (0 to remove the filter): ";
+    int odds = awaitValueInput();
+    list.setFilter(odds > 1 ? (list.length() > 1024 ? list.length() : 1024) : 0, 1.0 / odds);
+    cout << (odds > 1 ? "Filter On" : "Filter Off") << endl;
+}
+
 /**
  * Provides basic information about the program.
  */
@@ -0,0 +1,365 @@
+/**
+ * @brief Implementation of the list's socket server.
+ * @author Jennifer Teissler
+ */
+
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Server.h"
+#include "SortedLinkedList.h"
+#include "Journal.h"
+
+using std::string;
+
+static const size_t KEY_HEADER = 1 + sizeof(uint32_t);
+static const uint32_t MAX_KEY = 1 << 20;   // anything longer is a broken client
+static const size_t MAX_INPUT = 1 + 2 * (KEY_HEADER + MAX_KEY); // largest request, a range
+static const size_t READ_BUDGET = 1 << 20; // read at most this much per wakeup
+static const int MAX_EVENTS = 64;
+static const int TICK = 100;               // ms between checks for a stop request
+
+static volatile sig_atomic_t stopping = 0;
+
+static void requestStop(int) {
+    stopping = 1;
+};
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+};
+
+/**
+ * Decodes the key at offset into item. Returns the key's length in bytes,
+ * 0 if it hasn't fully arrived yet, or -1 if it can't be a valid key.
+ */
+static long readKey(const string & input, size_t offset, DataType & item) {
+    if (input.size() < offset + KEY_HEADER) {
+        return 0;
+    }
+    uint8_t kind = (uint8_t) input[offset];
+    uint32_t size;
+    memcpy(&size, input.data() + offset + 1, sizeof(uint32_t));
+
+    if ((kind == DataType::INTEGER && size != 4) || (kind == DataType::COMPOSITE && size != 8) ||
+        kind > DataType::COMPOSITE || size > MAX_KEY) {
+        return -1;
+    }
+    if (input.size() < offset + KEY_HEADER + size) {
+        return 0;
+    }
+    item = DataType((DataType::Kind) kind, input.data() + offset + KEY_HEADER, (int) size);
+    return (long) (KEY_HEADER + size);
+};
+
+static void writeKey(string & output, const DataType & item) {
+    uint32_t size = (uint32_t) item.getSize();
+    output.push_back((char) item.getKind());
+    output.append((const char *) &size, sizeof(uint32_t));
+    output.append(item.getBytes(), size);
+};
+
+Server::Server(SortedLinkedList & list, Journal * journal) : list(list) {
+    this->journal = journal;
+    this->listener = -1;
+    this->events = epoll_create1(0);
+};
+
+Server::~Server() {
+    for (auto & entry : this->connections) {
+        close(entry.first);
+        delete entry.second;
+    }
+    if (this->listener >= 0) {
+        close(this->listener);
+    }
+    if (!this->socketPath.empty()) {
+        unlink(this->socketPath.c_str());
+    }
+    if (this->events >= 0) {
+        close(this->events);
+    }
+};
+
+/**
+ * Listens on a Unix domain socket at path. A socket left behind at path by
+ * an earlier run is replaced, any other kind of file is left alone.
+ */
+bool Server::listenUnix(const string & path) {
+    struct sockaddr_un address;
+    struct stat existing;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    if (lstat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        unlink(path.c_str());
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    this->socketPath = path;
+    return startListening(fd);
+};
+
+/**
+ * Listens on a TCP port of the loopback interface only.
+ */
+bool Server::listenTcp(int port) {
+    struct sockaddr_in address;
+    int reuse = 1;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t) port);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        close(fd);
+        return false;
+    }
+    return startListening(fd);
+};
+
+bool Server::startListening(int fd) {
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;                 // the listener is the one without a connection
+
+    if (this->events < 0 || listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd) ||
+        epoll_ctl(this->events, EPOLL_CTL_ADD, fd, &event) != 0) {
+        close(fd);
+        return false;
+    }
+    this->listener = fd;
+    return true;
+};
+
+/**
+ * Serves connections until SIGINT or SIGTERM. Each wakeup reads and answers
+ * everything that has arrived, commits the journal once for all of it, and
+ * only then writes the replies, so nothing is acknowledged before it is
+ * durable.
+ */
+void Server::run() {
+    struct epoll_event ready[MAX_EVENTS];
+    std::vector<Connection *> answered;
+    stopping = 0;
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+
+    while (!stopping && this->listener >= 0) {
+        int count = epoll_wait(this->events, ready, MAX_EVENTS, TICK);
+        answered.clear();
+
+        for (int i = 0; i < count; ++i) {
+            Connection * connection = (Connection *) ready[i].data.ptr;
+            if (connection == NULL) {
+                acceptAll();
+            }
+            else if (ready[i].events & EPOLLOUT) {
+                if (!flush(connection)) {
+                    drop(connection);
+                }
+            }
+            else if (ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                if (receive(connection) && handle(connection)) {
+                    answered.push_back(connection);
+                }
+                else {
+                    drop(connection);
+                }
+            }
+        }
+
+        if (this->journal != NULL) {
+            this->journal->commit();       // one group commit for the whole wakeup
+        }
+        for (size_t i = 0; i < answered.size(); ++i) {
+            if (!flush(answered[i])) {
+                drop(answered[i]);
+            }
+        }
+    }
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+};
+
+void Server::acceptAll() {
+    int fd;
+    while ((fd = accept(this->listener, NULL, NULL)) >= 0) {
+        int on = 1;
+        setNonBlocking(fd);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // replies are batched already
+
+        Connection * connection = new Connection();
+        connection->fd = fd;
+        connection->watching = 0;
+        connection->closing = false;
+        this->connections[fd] = connection;
+
+        struct epoll_event event;
+        event.events = 0;
+        event.data.ptr = connection;
+        epoll_ctl(this->events, EPOLL_CTL_ADD, fd, &event);
+        watch(connection, EPOLLIN);
+    }
+};
+
+/**
+ * Reads whatever the connection has ready, up to READ_BUDGET at a time so
+ * one busy client can't hold up the rest. Input is buffered up to MAX_INPUT,
+ * which holds the largest valid request, so a full buffer always starts
+ * with a whole request and handle always makes progress on it. Returns
+ * false on a socket error.
+ */
+bool Server::receive(Connection * connection) {
+    char chunk[65536];
+    size_t received = 0;
+
+    while (received < READ_BUDGET && connection->input.size() < MAX_INPUT) {
+        size_t wanted = MAX_INPUT - connection->input.size();
+        ssize_t size = read(connection->fd, chunk, wanted < sizeof(chunk) ? wanted : sizeof(chunk));
+        if (size > 0) {
+            connection->input.append(chunk, size);
+            received += size;
+        }
+        else if (size == 0) {              // peer finished, still owed its replies
+            connection->closing = true;
+            break;
+        }
+        else if (errno == EINTR) {
+            continue;
+        }
+        else {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+    }
+    return true;
+};
+
+/**
+ * Answers every complete request in the connection's input, leaving any
+ * partial request at the end for the next read. Returns false if the
+ * client sent something that isn't a request.
+ */
+bool Server::handle(Connection * connection) {
+    const string & input = connection->input;
+    string & output = connection->output;
+    DataType low(0);
+    DataType high(0);
+    size_t offset = 0;
+
+    while (offset < input.size()) {
+        char operation = input[offset];
+        if (operation != INSERT && operation != DELETE && operation != RETRIEVE && operation != RANGE) {
+            return false;
+        }
+        long first = readKey(input, offset + 1, low);
+        long second = first > 0 && operation == RANGE ? readKey(input, offset + 1 + first, high) : 1;
+        if (first < 0 || second < 0) {
+            return false;
+        }
+        if (first == 0 || second == 0) {
+            break;                         // the rest hasn't arrived yet
+        }
+        offset += 1 + first + (operation == RANGE ? second : 0);
+
+        int before = this->list.length();
+        switch (operation) {
+            case INSERT:   this->list.insertItem(low);
+                           output.push_back((char) (this->list.length() > before));
+                           break;
+            case DELETE:   this->list.deleteItem(low);
+                           output.push_back((char) (this->list.length() < before));
+                           break;
+            case RETRIEVE: output.push_back((char) (this->list.search(low) != -1));
+                           break;
+            case RANGE: {
+                           this->found.clear();
+                           this->list.range(low, high, this->found);
+                           uint32_t count = (uint32_t) this->found.size();
+                           output.append((const char *) &count, sizeof(uint32_t));
+                           for (size_t i = 0; i < this->found.size(); ++i) {
+                               writeKey(output, this->found[i]);
+                           }
+                           break;
+                       }
+        }
+    }
+    connection->input.erase(0, offset);
+    return true;
+};
+
+/**
+ * Writes as much pending output as the socket takes. While output is left
+ * over, the connection stops being read from until the client catches up.
+ * Returns false once the connection should be dropped.
+ */
+bool Server::flush(Connection * connection) {
+    size_t sent = 0;
+
+    while (sent < connection->output.size()) {
+        ssize_t size = send(connection->fd, connection->output.data() + sent,
+                            connection->output.size() - sent, MSG_NOSIGNAL);
+        if (size >= 0) {
+            sent += size;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        else if (errno != EINTR) {
+            return false;
+        }
+    }
+    connection->output.erase(0, sent);
+
+    if (!connection->output.empty()) {
+        watch(connection, EPOLLOUT);
+    }
+    else if (connection->closing) {
+        return false;                      // every reply delivered, hang up
+    }
+    else {
+        watch(connection, EPOLLIN);
+    }
+    return true;
+};
+
+void Server::watch(Connection * connection, unsigned int wanted) {
+    if (connection->watching != wanted) {
+        struct epoll_event event;
+        event.events = wanted;
+        event.data.ptr = connection;
+        epoll_ctl(this->events, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->watching = wanted;
+    }
+};
+
+void Server::drop(Connection * connection) {
+    epoll_ctl(this->events, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    this->connections.erase(connection->fd);
+    delete connection;
+};
@@ -9,16 +9,24 @@
 
 #include <cstdlib>
 #include "SortedLinkedList.h"
+#include "Journal.h"
 
 using std::ostream;
 
 SortedLinkedList::SortedLinkedList() {
     this->count = 0;    // initialize the list to have a size of 0
     this->head = NULL;  // initialize the head pointer to nothing
+    this->pending = NULL; // nothing waiting to be sorted in
+    this->pendingTail = &this->pending;
+    this->deferred = false; // sort on every insert by default
+    this->filter = NULL;  // no membership filter by default
+    this->journal = NULL; // no journal until one is attached
 };
 
 SortedLinkedList::~SortedLinkedList() {
+   this->journal = NULL; // destruction is not a clear, keep it out of the journal
    this->clear();       // call the clear function to destruct the class
+   delete this->filter;
 };
 
 int SortedLinkedList::length() const {
@@ -26,26 +34,146 @@ int SortedLinkedList::length() const {
 };
 
 void SortedLinkedList::insertItem(DataType & item) {
+    if (this->journal != NULL) {
+        this->journal->append(Journal::INSERT, item); // log ahead of the change
+    }
     ListNode * node = new ListNode(item); // create new element
-    ListNode * * current = &this->head;   // create a pointer to the pointer pointing to the first element
-    // SEARCH
-    // check that the current element is not null 
-    // check if the element to insert is greater than or equal to the current
-    while(*current != NULL && node->item.compareTo((**current).item) != DataType::LESSER) {
-        current = &(**current).next;      // point current at the next element that it is pointing to
+    STATS_COUNT(allocations);
+    if (this->deferred) {                 // append to the unsorted tail, no walk at all
+        *this->pendingTail = node;
+        this->pendingTail = &node->next;
+        this->count++;
     }
-    // INSERT
-    node->next = *current;                // set the next element to point to the next item
-    *current = node;                      // set the previous element to point to the new element
-    this->count++;                        // increment list size by 1
+    else {
+        STATS_WALK_BEGIN;
+        ListNode * * current = &this->head; // create a pointer to the pointer pointing to the first element
+        // SEARCH
+        // check that the current element is not null 
+        // check if the element to insert is greater than or equal to the current
+        while(*current != NULL && compare(node->item, *current) != DataType::LESSER) {
+            STATS_COUNT(visits);
+            current = &(**current).next;  // point current at the next element that it is pointing to
+        }
+        // INSERT
+        node->next = *current;            // set the next element to point to the next item
+        *current = node;                  // set the previous element to point to the new element
+        this->count++;                    // increment list size by 1
+        STATS_WALK_END;
+    }
+
+    if (this->filter != NULL) {
+        this->filter->add(item);
+        if (this->count > this->filter->getCapacity()) { // outgrown, resize to keep its rate
+            setFilter(2 * this->filter->getCapacity(), this->filter->getRate());
+        }
+    }
+};
+
+/**
+ * Replaces the contents of the list with items, which must already be in
+ * ascending order. Every node is appended at the tail in a single pass
+ * rather than walking the list once per item.
+ */
+void SortedLinkedList::build(std::vector<DataType> & items) {
+    clear();
+    ListNode * * tail = &this->head;      // pointer to the pointer at the end of the list
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (this->journal != NULL) {
+            this->journal->append(Journal::INSERT, items[i]); // log ahead of the change
+        }
+        *tail = new ListNode(items[i]);   // append the next element
+        STATS_COUNT(allocations);
+        tail = &(**tail).next;            // and move the tail along to it
+    }
+    this->count = (int) items.size();
+
+    if (this->filter != NULL) {
+        setFilter(this->filter->getCapacity(), this->filter->getRate()); // refill from the new contents
+    }
+};
+
+/**
+ * Compares an item against a node's item. Every comparison made while
+ * walking the list passes through here so that it can be counted.
+ */
+DataType::Comparison SortedLinkedList::compare(DataType & item, ListNode * node) const {
+    STATS_COUNT(comparisons);
+    return item.compareTo(node->item);
+};
+
+/**
+ * Sorts any pending inserts and merges them into the list, so that every
+ * read still sees the items in order. Called by each read, it does nothing
+ * when no inserts are pending.
+ *
+ * The pending nodes are merge sorted in place, bottom up: each node is
+ * merged into a run of length 1, which is merged with the run of length 1
+ * already held, if any, into a run of length 2, and so on, like carrying
+ * in binary addition. No node is copied and no list is walked just to
+ * split it, and equal items keep their insertion order.
+ */
+void SortedLinkedList::settle() const {
+    if (this->pending == NULL) {
+        return;
+    }
+    ListNode * runs[64] = { NULL };       // runs[i] holds 2^i nodes, or nothing
+
+    while (this->pending != NULL) {
+        ListNode * carry = this->pending;
+        this->pending = carry->next;
+        carry->next = NULL;
+        int i = 0;
+        for (; runs[i] != NULL; ++i) {    // runs[i] came first, so it goes first
+            carry = merge(runs[i], carry);
+            runs[i] = NULL;
+        }
+        runs[i] = carry;
+    }
+    ListNode * sorted = NULL;
+    for (int i = 0; i < 64; ++i) {        // higher runs are older, so they go first
+        if (runs[i] != NULL) {
+            sorted = merge(runs[i], sorted);
+        }
+    }
+    this->head = merge(this->head, sorted); // the list's own items go first on ties
+    this->pendingTail = &this->pending;
+};
+
+/**
+ * Merges two sorted runs of nodes into one, taking from first on ties.
+ */
+ListNode * SortedLinkedList::merge(ListNode * first, ListNode * second) const {
+    ListNode * merged = NULL;
+    ListNode * * tail = &merged;
+
+    while (first != NULL && second != NULL) {
+        if (compare(second->item, first) == DataType::LESSER) {
+            *tail = second;
+            second = second->next;
+        }
+        else {
+            *tail = first;
+            first = first->next;
+        }
+        tail = &(**tail).next;
+    }
+    *tail = first != NULL ? first : second;
+    return merged;
 };
 
 void SortedLinkedList::deleteItem(DataType & item) {
+    if (this->journal != NULL) {
+        this->journal->append(Journal::DELETE, item); // log ahead of the change
+    }
+    settle();
+    STATS_WALK_BEGIN;
     ListNode * * current = &this->head;   // create a pointer to the pointer pointing to the first element
     // SEARCH
     // check that the current element is not null 
     // check whether the element to delete has been found
-    while(*current != NULL && (**current).item.compareTo(item) != DataType::EQUAL) {
+    while(*current != NULL && compare(item, *current) != DataType::EQUAL) {
+        STATS_COUNT(visits);
         current = &(**current).next;      // point current at the next element that it is pointing to
     }
     // DELETE
@@ -54,33 +182,86 @@ void SortedLinkedList::deleteItem(DataType & item) {
         *current = temp->next;            // point the previous element at the next element
         this->count--;                    // decrement the list size by 1
         delete temp;                      // delete the element from memory
+        STATS_COUNT(deallocations);
+        if (this->filter != NULL) {
+            this->filter->remove(item);
+        }
     } 
+    STATS_WALK_END;
 };
 
 int SortedLinkedList::search(DataType & item) const {
+    if (this->filter != NULL && !this->filter->mayContain(item)) {
+        return -1;                          // certainly missing, skip the walk
+    }
+    settle();
+    STATS_WALK_BEGIN;
     ListNode * current = this->head;        // store a pointer to the first item in the list
 
     for (int i = 0; i < this->count; ++i) { // iterate through the list until a match is found
-        if (current->item.compareTo(item) == DataType::EQUAL) {
+        STATS_COUNT(visits);
+        if (compare(item, current) == DataType::EQUAL) {
+            STATS_WALK_END;
             return i;                       // return index of the value if found in the list
         }
         current = current->next;
     }
+    STATS_WALK_END;
+    if (this->filter != NULL) {
+        this->filter->recordFalsePositive();
+    }
     return -1;                              // return -1 if the value is not found in the list
 };
 
+/**
+ * Appends every item from low to high inclusive to items, in order. The
+ * walk stops at the first item past high.
+ */
+void SortedLinkedList::range(DataType & low, DataType & high, std::vector<DataType> & items) const {
+    settle();
+    STATS_WALK_BEGIN;
+    ListNode * current = this->head;
+
+    while (current != NULL && compare(low, current) == DataType::GREATER) { // skip items below low
+        STATS_COUNT(visits);
+        current = current->next;
+    }
+    while (current != NULL && compare(high, current) != DataType::LESSER) { // collect up to high
+        STATS_COUNT(visits);
+        items.push_back(current->item);
+        current = current->next;
+    }
+    STATS_WALK_END;
+};
+
 void SortedLinkedList::clear() {
+    if (this->journal != NULL) {
+        DataType none(0);
+        this->journal->append(Journal::CLEAR, none); // log ahead of the change
+    }
     ListNode * current;                // create a temporary pointer 
 
     while (this->head != NULL) {       // iterate until the end of the list
         current = this->head;          // store the current item for deletion
         this->head = this->head->next; // move to the next item
         delete current;                // delete the current item
+        STATS_COUNT(deallocations);
     }
+    while (this->pending != NULL) {    // and the same for any pending inserts
+        current = this->pending;
+        this->pending = this->pending->next;
+        delete current;
+        STATS_COUNT(deallocations);
+    }
+    this->pendingTail = &this->pending;
     this->count = 0;                   // reset the list size to zero
+    if (this->filter != NULL) {
+        this->filter->reset();
+    }
 };      
 
 void SortedLinkedList::pairwiseSwap() {
+    settle();
     if (this->count < 2) {                  // the swap doesn't apply here
         return;
     }
@@ -106,11 +287,98 @@ void SortedLinkedList::pairwiseSwap() {
 };
 
 ostream & operator<<(ostream & stream, const SortedLinkedList & list) {
+    list.settle();                                 // sort in any pending inserts
     ListNode * current = list.head;                // start at the first element
 
     while (current != NULL) {                      // iterate until the end of the list
-        stream << current->item.getValue() << " "; // send current value into stream
+        stream << current->item << " ";            // send current value into stream
         current = current->next;                   // advance to next element
     }
     return stream;                                 // return the modified stream
 };
+
+/**
+ * Puts a counting Bloom filter sized for capacity items in front of search,
+ * so most searches for missing items return after a few hashed probes
+ * instead of a walk down the list. The filter is filled from the list and
+ * kept in step with every later change, and is resized whenever the list
+ * outgrows it. A capacity of 0 removes the filter.
+ */
+void SortedLinkedList::setFilter(int capacity, double falsePositiveRate) {
+    delete this->filter;
+    this->filter = NULL;
+
+    if (capacity > 0) {
+        this->filter = new BloomFilter(capacity > this->count ? capacity : this->count,
+                                       falsePositiveRate);
+        for (ListNode * current = this->head; current != NULL; current = current->next) {
+            this->filter->add(current->item);
+        }
+        for (ListNode * current = this->pending; current != NULL; current = current->next) {
+            this->filter->add(current->item);
+        }
+    }
+};
+
+/**
+ * In deferred sort mode inserts are appended to an unsorted tail in O(1),
+ * and the whole tail is sorted and merged in, in O(n log n), by the next
+ * read: search, range, deleteItem, pairwiseSwap or printing. Suited to
+ * write heavy phases that insert a lot before reading anything. Turning the
+ * mode off sorts in anything still pending.
+ */
+void SortedLinkedList::setDeferredSort(bool enabled) {
+    this->deferred = enabled;
+    if (!enabled) {
+        settle();
+    }
+};
+
+bool SortedLinkedList::isDeferredSort() const {
+    return this->deferred;
+};
+
+/**
+ * How well the filter is doing, all zeros if there is no filter.
+ */
+FilterStats SortedLinkedList::filterStats() const {
+    return this->filter != NULL ? this->filter->stats(this->count) : FilterStats();
+};
+
+/**
+ * Logs every following insert, delete and clear to the journal, pass NULL
+ * to stop.
+ */
+void SortedLinkedList::attachJournal(Journal * journal) {
+    this->journal = journal;
+};
+
+ListStats SortedLinkedList::stats() const {
+#ifdef LIST_STATS
+    return this->statistics; // snapshot of the counters collected so far
+#else
+    return ListStats();      // counters are compiled out, report zeros
+#endif
+};
+
+void SortedLinkedList::resetStats() {
+#ifdef LIST_STATS
+    this->statistics = ListStats();
+#endif
+    if (this->filter != NULL) {
+        this->filter->resetStats();
+    }
+};
+
+#ifdef LIST_STATS
+/**
+ * Closes off a single walk, the number of nodes visited since it started
+ * is how far down the list the walk reached.
+ */
+void SortedLinkedList::recordWalk(unsigned long start) const {
+    int walk = (int) (this->statistics.visits - start);
+    if (walk > this->statistics.maxWalk) {
+        this->statistics.maxWalk = walk;
+    }
+};
+#endif
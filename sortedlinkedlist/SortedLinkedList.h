@@ -11,25 +11,52 @@
 #define SORTEDLINKEDLIST_H
 
 #include "ListNode.h"
+#include "ListStats.h"
+#include "BloomFilter.h"
 #include <iostream>
+#include <vector>
 
 using std::ostream;
 
+class Journal;
+
 class SortedLinkedList {
     public:
         SortedLinkedList();
         ~SortedLinkedList();
         int length() const;
         void insertItem(DataType & item);
+        void build(std::vector<DataType> & items);
         void deleteItem(DataType & item);
         int search(DataType & item) const;
+        void range(DataType & low, DataType & high, std::vector<DataType> & items) const;
         void clear();
         void pairwiseSwap();
+        void setDeferredSort(bool enabled);
+        bool isDeferredSort() const;
+        void setFilter(int capacity, double falsePositiveRate = 0.01);
+        FilterStats filterStats() const;
+        void attachJournal(Journal * journal);
+        ListStats stats() const;
+        void resetStats();
         friend ostream & operator<<(ostream & stream, const SortedLinkedList & list);
+        friend class Journal;
 
     private:
         int count;
-        ListNode * head;
+        mutable ListNode * head;
+        mutable ListNode * pending;       // unsorted inserts, merged in on the next read
+        mutable ListNode * * pendingTail; // the last pending node's next, or &pending
+        bool deferred;
+        BloomFilter * filter;
+        Journal * journal;
+#ifdef LIST_STATS
+        mutable ListStats statistics;
+        void recordWalk(unsigned long start) const;
+#endif
+        DataType::Comparison compare(DataType & item, ListNode * node) const;
+        void settle() const;
+        ListNode * merge(ListNode * first, ListNode * second) const;
 };
 
 #endif